@@ -0,0 +1,28 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <nds/ndstypes.h>
+
+//same result as swiCRC16(crc, data, len), four bytes per step
+u16 crc16(u16 crc, void const* data, u32 len);
+
+#endif
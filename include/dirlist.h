@@ -0,0 +1,58 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef DIRLIST_H
+#define DIRLIST_H
+
+#include <nds/ndstypes.h>
+
+enum {
+	SORT_NAME,
+	SORT_TITLE,
+	SORT_CODE,
+	SORT_SIZE,
+	SORT_NONE,
+	SORT_COUNT
+};
+
+//one listed file or folder, strings are offsets into the string pool
+typedef struct {
+	u64 prefix;		//leading bytes of the sort key, what the radix sort orders by
+	u32 key;		//full sort key, breaks ties in the prefix
+	u32 name;
+	u32 size;
+	bool directory;
+} DirEntry;
+
+extern const char* sortNames[SORT_COUNT];
+
+bool dirListOpen(char const* path, int sort);
+bool dirListStep(u32 ticks);
+bool dirListBusy();
+bool dirListSpilled();
+void dirListFree();
+
+int dirListCount();
+char const* dirListName(int i);
+bool dirListIsDir(int i);
+
+int dirListJump(int i, int dir);
+
+#endif
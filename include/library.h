@@ -0,0 +1,53 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <nds/ndstypes.h>
+
+//one ROM found on the SD card, strings are offsets into the string pool
+typedef struct {
+	u32 path;		//full path
+	u32 name;		//case-folded file name
+	u32 title;		//case-folded banner title
+	u32 code;		//case-folded game code
+} LibraryEntry;
+
+//start of one searchable word, sorted by the word it points at
+typedef struct {
+	u32 key;
+	u32 entry;
+} LibraryToken;
+
+//called as ROMs are found while the library builds, so the caller can show progress
+typedef void (*LibraryProgress)(int found);
+
+bool libraryLoad();
+bool librarySave();
+int libraryBuild(LibraryProgress progress);
+void libraryFree();
+
+int libraryCount();
+char const* libraryPath(int entry);
+
+int librarySearch(char const* query, int* results, int max);
+
+#endif
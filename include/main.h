@@ -21,6 +21,8 @@
 #define MAIN_H
 
 void installMenu();
+void installPrompt(char* fpath);
+void searchMenu();
 void testMenu();
 
 extern PrintConsole topScreen;
@@ -28,6 +30,26 @@ extern PrintConsole bottomScreen;
 
 void clearScreen(PrintConsole* screen);
 
+bool mountNitroFS();
+
+//startup timeline in cpuGetTiming() ticks, the first three since main() started
+enum {
+	STARTUP_SCREENS,
+	STARTUP_FAT,
+	STARTUP_MENU,
+	STARTUP_NITRO,	//how long mountNitroFS() took, 0 until it has run
+	STARTUP_COUNT
+};
+
+extern u32 startupTicks[STARTUP_COUNT];
+
+//app data on the SD card, next to the install template. Host tests build with their own root
+#ifndef APP_DATA_ROOT
+#define APP_DATA_ROOT "/_nds"
+#endif
+
+#define APP_DATA_DIR APP_DATA_ROOT "/NDSForwarder"
+
 #define abs(X) ( (X) < 0 ? -(X): (X) )
 #define sign(X) ( ((X) > 0) - ((X) < 0) )
 #define repeat(X) for (int _I_ = 0; _I_ < (X); _I_++)
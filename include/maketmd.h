@@ -36,6 +36,47 @@ distribution.
 #ifndef MAKETMD_H
 #define MAKETMD_H
 
+#include <nds.h>
+
+#include "sha1.h"
+
+#define TMD_SIZE 0x208
+
+//builds a TMD from an app fed in pieces, so it can come from a file, RAM or a copy in progress
+typedef struct {
+	u8 tmd[TMD_SIZE];
+	Sha1Context sha1;
+	u32 size;	//bytes fed so far
+} TmdBuilder;
+
+void tmdInit(TmdBuilder* b, tDSiHeader const* header);
+void tmdUpdate(TmdBuilder* b, void const* data, u32 len);
+void tmdFinal(TmdBuilder* b, u8* tmd);
+
+//everything that decides the bytes of an installed app, so an app built from the same parts reuses its hash
+typedef struct {
+	u32 tidLow;
+	u32 tidHigh;
+	u16 templateCrc;	//template as extracted, tells builds apart
+	u16 headerCrc;		//whole patched header
+	u16 bannerCrc[4];
+	u32 pathHash;		//game path as written into the app
+} TmdKey;
+
+#define TMD_CACHE_PATH APP_DATA_DIR "/tmdcache.bin"
+
+u32 tmdPathHash(void const* data, u32 len);
+
 int maketmd(char* input, char* tmdPath);
+int maketmdCached(char* input, char* tmdPath, TmdKey const* key);
+
+enum {
+	TMD_VERIFY_OK,
+	TMD_VERIFY_REPAIRED,
+	TMD_VERIFY_MISMATCH,	//wrong, and left alone
+	TMD_VERIFY_ERROR	//no app to check against
+};
+
+int tmdVerify(char const* contentPath, bool repair);
 
 #endif
\ No newline at end of file
@@ -32,6 +32,7 @@ typedef struct {
 	int cursor;
 	int page;
 	int itemCount;
+	int itemTotal;	//items across all pages, 0 if unknown
 	bool nextPage;
 	int changePage;
 	char header[32];
@@ -49,5 +50,6 @@ void clearMenu(Menu* m);
 void printMenu(Menu* m);
 
 bool moveCursor(Menu* m);
+bool jumpCursor(Menu* m, int index);
 
 #endif
\ No newline at end of file
@@ -42,6 +42,30 @@
 		* Updated GBA SLOT detection to check for game code and header CRC.
 	2020-08-24 v0.11 - SDNAND support (by RocketRobz)
 		* Added support for being mounted from SDNAND, if app is launched by hiyaCFW.
+	2026-10-18 v0.12 - in-RAM directory index
+		* FNT and FAT are loaded once by nitroFSInit(), names are looked up through a hash of
+		  (parent dir, name) so open, stat, chdir and diropen no longer touch the file.
+	2026-10-18 v0.13 - block cache
+		* Reads from the .nds file go through a small LRU cache of sector aligned blocks, size
+		  and count set with nitroFSSetCache(), hit rate from nitroFSGetCacheStats().
+	2026-10-18 v0.14 - mount context
+		* The globals moved into struct nitroMount, handles point at their mount and read with
+		  nitroPread() at their own position through a small per-handle buffer.
+	2026-10-18 v0.15 - export
+		* nitroFSExport() copies a file's byte range from the image straight into a FILE.
+	2026-10-18 v0.16 - compressed files
+		* name.lz files holding LZ77 data open as name and unpack as they are read.
+	2026-10-18 v0.17 - resident images
+		* With nitroFSSetResident(), an image small enough is read into RAM whole by nitroFSInit().
+	2026-10-18 v0.18 - more mounts
+		* Each devoptab carries its mount in deviceData, nitroFSMount() adds any .nds under its own
+		  device name and nitroFSUnmount() takes it away again. A name already in use is refused,
+		  AddDevice() would replace that device. Separate mounts can be read from separate threads,
+		  but a mount's file position, block cache and stats aren't locked, so one mount is only
+		  safe to use from one thread at a time.
+	2026-10-18 v0.19 - host build
+		* __itcm and NITRONOCASHID can come from the build, so tools/ compiles this file for the
+		  host tests and bench_nitrofs against a stand-in for libnds.
 */
 
 #ifndef NITROFS_H
@@ -57,6 +81,8 @@ extern "C" {
 #endif
 
 	int nitroFSInit(const char *ndsfile);
+	int nitroFSMount(const char *name, const char *ndsfile);
+	int nitroFSUnmount(const char *name);
 	DIR_ITER *nitroFSDirOpen(struct _reent *r, DIR_ITER *dirState, const char *path);
 	int nitroDirReset(struct _reent *r, DIR_ITER *dirState);
 	int nitroFSDirNext(struct _reent *r, DIR_ITER *dirState, char *filename, struct stat *st);
@@ -68,11 +94,44 @@ extern "C" {
 	int nitroFSFstat(struct _reent *r, void *fd, struct stat *st);
 	int nitroFSstat(struct _reent *r, const char *file, struct stat *st);
 	int nitroFSChdir(struct _reent *r, const char *name);
+
+	//Cache hit rate, for tuning the block count and size
+	struct nitroCacheStats {
+		u32 hits;        //reads served from a cached block
+		u32 misses;      //blocks read in from the file
+		u32 deviceReads; //freads of the .nds file, including whole block reads that skip the cache
+		u32 deviceBytes; //bytes those freads returned
+		u32 deviceSeeks; //fseeks of the .nds file
+		u32 resident;    //bytes of the image held in RAM, 0 if it isnt
+	};
+
+	int nitroFSSetCache(int blocks, u32 blockSize); //blockSize in whole sectors, 0 blocks turns the cache off
+	void nitroFSGetCacheStats(struct nitroCacheStats *stats);
+	void nitroFSResetCacheStats(void);
+	void nitroFSSetResident(u32 maxSize); //nitroFSInit() loads images with up to maxSize bytes of nitro data into RAM, 0 never
+
+	//Called with every piece nitroFSExport() copies, for hashing it on the way
+	typedef void (*nitroHashFunc)(void *ctx, const void *data, size_t len);
+
+	ssize_t nitroFSExport(const char *path, FILE *dst, nitroHashFunc hash, void *hashCtx); //bytes copied, or -1 with errno set
 #define LOADERSTR "PASS" //look for this
 #define LOADERSTROFFSET 0xac
 #define LOADEROFFSET 0x0200
 #define FNTOFFSET 0x40
+#define FNTSIZEOFFSET 0x44
 #define FATOFFSET 0x48
+#define FATSIZEOFFSET 0x4C
+
+#define NITROCACHEBLOCKS 8       //default number of cached blocks
+#define NITROCACHEBLOCKSIZE 0x1000 //default block size, a multiple of the 0x200 sector
+
+#define NITRODEVNAMEMAX 16 //device name length for nitroFSMount(), with the zero byte
+
+#define NITROHANDLEBUF 0x200     //read buffer in each open file
+#define NITROEXPORTCHUNK 0x8000 //nitroFSExport() transfer size, a multiple of the 0x200 sector
+
+#define NITROLZTYPE 0x10     //LZ77 compression type in the low byte of a .lz header
+#define NITROLZWINDOW 0x1000 //how far back an LZ77 reference can reach
 
 #define NITRONAMELENMAX 0x80  //max file name is 127 +1 for zero byte :D
 #define NITROMAXPATHLEN 0x100 //256 bytes enuff?
@@ -95,13 +154,89 @@ extern "C" {
 		u32 bottom; //end of file in rom image
 	};
 
+	//Name of a file or dir in the in-RAM FNT, for checking hash matches
+	struct nitroNode {
+		u32 name;   //offset of the name in the FNT
+		u16 parent; //dir the entry is listed in
+		u8 len;     //name length
+	};
+
+	//One cached block of the image
+	struct nitroCacheBlock {
+		off_t start; //rom offset of the block, -1 if empty
+		u32 len;     //bytes valid, short at the end of the image
+		u32 used;    //cacheClock value at the last hit
+		u8 *data;
+	};
+
+	//Everything known about one mounted image
+	struct nitroMount {
+		FILE *file;    //the .nds file, NULL when reading from the gba slot
+		off_t lastpos; //where the last fread left file, to skip needless fseeks
+		u32 fntOffset; //offset to start of filename table
+		u32 fatOffset; //offset to start of file alloc table
+		bool hasLoader;
+		u16 chdirpathid; //current dir for relative paths
+
+		//in-RAM copy of the FNT and FAT, plus the name hash built from them
+		u8 *fntData;
+		u32 fntSize;
+		struct ROM_FAT *fatData;
+		u32 fatCount;
+		u16 dirCount;
+		struct nitroNode *fileNodes; //indexed by file id
+		struct nitroNode *dirNodes;  //indexed by dir id & NITRODIRMASK
+		u16 *nameHash;               //node ids, 0xffff if free
+		u32 nameHashMask;
+		u32 *lzSize; //unpacked size of each compressed file by id, 0 if stored plain. NULL if none are
+
+		struct nitroCacheBlock *cacheBlocks;
+		int cacheCount;
+		u32 cacheBlockSize;
+		u32 cacheClock;
+		struct nitroCacheStats stats;
+
+		u8 *image;        //the resident part of the image, NULL if reads go to the file
+		off_t imageStart; //rom offset of image
+		u32 imageSize;
+	};
+
+	ssize_t nitroPread(struct nitroMount *mnt, off_t pos, void *ptr, size_t len);
+
+	//Where an open compressed file is in its unpacking
+	struct nitroLz {
+		off_t start;  //first compressed byte in the image
+		off_t end;    //end of the compressed data
+		off_t in;     //next compressed byte to read
+		u32 size;     //unpacked size
+		u32 out;      //bytes unpacked so far
+		u8 flags;     //current flag byte
+		u8 bits;      //flags not used yet
+		u16 copyLen;  //bytes left in the current back reference
+		u16 copyDist; //and how far back it reaches
+		u16 inLen;
+		u16 inAt;
+		u8 inBuf[0x200];
+		u8 window[NITROLZWINDOW]; //the last 4KB unpacked
+	};
+
+	struct nitroLz *nitroLzOpen(off_t start, off_t end, u32 size);
+	void nitroLzReset(struct nitroLz *lz);
+	size_t nitroLzDecode(struct nitroMount *mnt, struct nitroLz *lz, u8 *dst, size_t len);
+
 	struct nitroFSStruct {
 		off_t pos;   //where in the file am i?
 		off_t start; //where in the rom this file starts
 		off_t end;   //where in the rom this file ends
+		struct nitroMount *mnt;
+		struct nitroLz *lz; //NULL unless the file is compressed, pos/start/end are unpacked offsets if it is
+		off_t bufStart;     //rom offset of buf
+		u32 bufLen;     //bytes valid in buf
+		u8 buf[NITROHANDLEBUF];
 	};
 
 	struct nitroDIRStruct {
+		struct nitroMount *mnt;
 		off_t pos;     //where in the file am i?
 		off_t namepos; //ptr to next name to lookup in list
 		struct ROM_FAT romfat;
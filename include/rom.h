@@ -59,6 +59,8 @@ typedef enum {
 	NDS_BANNER_SIZE_DSi			= 0x23C0,
 } sNDSBannerSize;
 
+bool isRomFile(char const* fname);
+
 tDSiHeader* getRomHeader(char const* fpath);
 tNDSHeader* getRomHeaderNDS(char const* fpath);
 sNDSBannerExt* getRomBanner(char const* fpath);
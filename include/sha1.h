@@ -0,0 +1,44 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <nds.h>
+
+#define SHA1_DIGEST_LENGTH 20
+
+//either our own sha1 or the DSi BIOS one, picked when the context is set up
+typedef struct {
+	u32 state[5];
+	u64 length;		//bytes fed so far
+	u8 block[64];	//partial block waiting for more data
+	bool bios;
+	swiSHA1context_t biosContext;
+} Sha1Context;
+
+void sha1SetBios(bool enable);
+bool sha1GetBios();
+
+void sha1Init(Sha1Context* ctx);
+void sha1Update(Sha1Context* ctx, void const* data, u32 len);
+void sha1Final(u8* digest, Sha1Context* ctx);
+void sha1Calc(u8* digest, void const* data, u32 len);
+
+#endif
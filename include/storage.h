@@ -44,6 +44,11 @@ bool dirExists(char const* path);
 bool deleteDir(char const* path);
 unsigned long long getDirSize(char const* path);
 
+//installed titles
+bool titleExists(u32 tidHigh, u32 tidLow);
+void titleAdded(u32 tidHigh, u32 tidLow);
+void titleRemoved(u32 tidHigh, u32 tidLow);
+
 //home menu
 int getMenuSlots();
 int getMenuSlotsFree();
@@ -55,9 +60,35 @@ unsigned long long getSDCardSize();
 unsigned long long getSDCardFree();
 #define getSDCardUsedSpace() (getSDCardSize() - getSDCardFree())
 
+//SD space ledger
+unsigned long long sdRoundCluster(unsigned long long size);
+unsigned long long sdLedgerFree();
+bool sdReserve(unsigned long long const* sizes, int count);
+void sdLedgerResize(unsigned long long oldSize, unsigned long long newSize);
+
 //internal storage
 unsigned long long getDsiSize();
 unsigned long long getDsiFree();
 #define getDsiUsed() (getDSIStorageSize() - getDSIStorageFree())
 
+//storage stats, worked out a step at a time in spare frame time
+enum {
+	STORAGE_STAT_SLOTS,
+	STORAGE_STAT_SD,
+	STORAGE_STAT_DSI,
+	STORAGE_STAT_COUNT
+};
+
+typedef struct {
+	bool ready[STORAGE_STAT_COUNT];
+	int slotsFree;
+	unsigned long long sdFree;
+	unsigned long long sdSize;
+	unsigned long long dsiFree;
+} StorageStats;
+
+void storageStatsInvalidate();
+bool storageStatsStep(u32 ticks);
+StorageStats const* getStorageStats();
+
 #endif
\ No newline at end of file
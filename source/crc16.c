@@ -0,0 +1,72 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <nds.h>
+
+#include "crc16.h"
+
+//reflected 0x8005, the polynomial the BIOS uses
+#define CRC16_POLY 0xA001
+
+//table[k][i] is byte i pushed through k more zero bytes, so four table lookups stand in for four bytes
+static u16 table[4][256];
+static bool tableReady = false;
+
+static void _crc16Table()
+{
+	for (int i = 0; i < 256; i++)
+	{
+		u16 crc = i;
+
+		for (int j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ CRC16_POLY : crc >> 1;
+
+		table[0][i] = crc;
+	}
+
+	for (int i = 0; i < 256; i++)
+	{
+		for (int k = 1; k < 4; k++)
+			table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xFF];
+	}
+
+	tableReady = true;
+}
+
+ITCM_CODE u16 crc16(u16 crc, void const* data, u32 len)
+{
+	if (!tableReady)
+		_crc16Table();
+
+	u8 const* p = (u8 const*)data;
+
+	while (len >= 4)
+	{
+		u16 x = crc ^ (p[0] | (p[1] << 8));
+		crc = table[3][x & 0xFF] ^ table[2][x >> 8] ^ table[1][p[2]] ^ table[0][p[3]];
+
+		p += 4;
+		len -= 4;
+	}
+
+	while (len-- > 0)
+		crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+
+	return crc;
+}
@@ -0,0 +1,945 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <nds.h>
+
+#include "dirlist.h"
+#include "main.h"
+#include "rom.h"
+#include "storage.h"
+
+#define NO_STRING 0xFFFFFFFF
+#define KEY_LENGTH 512
+#define NAME_LENGTH 256
+
+//folders bigger than one run are sorted in runs, spilled to the SD card and merged as pages are read
+#define RUN_ENTRIES_DS 2048
+#define RUN_ENTRIES_DSI 16384
+#define MAX_RUNS 128
+#define RUN_BUFFER 1024
+#define WINDOW 32
+
+#define RUNS_PATH APP_DATA_DIR "/runs.tmp"
+#define MERGE_PATH APP_DATA_DIR "/merge.tmp"
+
+//keys from sorted modes are prefixed so folders always come first
+#define PREFIX_FILE (1ULL << 63)
+
+//leading letters of the sort key, slot 0 is anything not A-Z
+#define LETTER_COUNT 27
+
+const char* sortNames[SORT_COUNT] = {
+	"Name",
+	"Title",
+	"Game code",
+	"Size",
+	"Unsorted"
+};
+
+static DirEntry* entries = NULL;
+static u32 entryCount = 0;
+static u32 entryCap = 0;
+
+static char* pool = NULL;
+static u32 poolSize = 0;
+static u32 poolCap = 0;
+
+//first entry of every run of entries sharing the folder flag and the leading letter of
+//their sort key, what L and R jump between
+static u32* jumps = NULL;
+static u32 jumpCount = 0;
+static u32 jumpCap = 0;
+static int lastGroup = -1;
+
+//header of one entry in a spilled run, followed by the key and the name
+typedef struct {
+	u64 prefix;
+	u16 keyLength;
+	u16 nameLength;
+	bool directory;
+} RunRecord;
+
+//read side of one sorted run, with the record at its head
+typedef struct {
+	u32 pos;
+	u32 end;
+	u32 bufPos;
+	u32 bufLen;
+	u8 buffer[RUN_BUFFER];
+	RunRecord head;
+	char key[KEY_LENGTH];
+	char name[NAME_LENGTH];
+} RunReader;
+
+//folder being listed, read a slice at a time by dirListStep()
+static DIR* listDir = NULL;
+static char listPath[512];
+static int listSort = SORT_NAME;
+static sNDSBannerExt* listBanner = NULL;
+static bool listing = false;
+
+static bool spilled = false;
+static FILE* runFile = NULL;
+static FILE* mergeFile = NULL;
+
+static u32 runStart[MAX_RUNS+1];
+static int runCount = 0;
+static RunReader* runs = NULL;
+
+//min-heap of runs by their head record
+static int* heap = NULL;
+static int heapSize = 0;
+
+static u32 totalCount = 0;
+static u32 mergedCount = 0;
+static u32 mergeEnd = 0;
+static u32 mergeCharged = 0;	//how much of the merge file the SD ledger has been charged for
+
+//offset in the merge file of every WINDOW-th merged entry
+static u32* chunkOffsets = NULL;
+static u32 chunkCap = 0;
+
+static u32 windowStart = 0;
+static u32 windowCount = 0;
+static char (*windowNames)[NAME_LENGTH] = NULL;
+static bool windowDirs[WINDOW];
+
+static bool _reserve(void** buf, u32* cap, u32 needed, u32 size)
+{
+	if (needed <= *cap)
+		return true;
+
+	u32 newCap = (*cap > 0) ? *cap : 256;
+	while (newCap < needed)
+		newCap *= 2;
+
+	void* p = realloc(*buf, newCap * size);
+	if (!p) return false;
+
+	*buf = p;
+	*cap = newCap;
+	return true;
+}
+
+static u32 _addString(char const* str)
+{
+	u32 len = strlen(str) + 1;
+
+	if (!_reserve((void**)&pool, &poolCap, poolSize + len, sizeof(char)))
+		return NO_STRING;
+
+	u32 offset = poolSize;
+	memcpy(pool + offset, str, len);
+	poolSize += len;
+
+	return offset;
+}
+
+//case-folds str, and writes each run of digits as its length followed by the digits
+//so that plain strcmp() puts "2" before "10"
+static void _naturalKey(char const* str, char* out)
+{
+	int len = 0;
+
+	while (*str != '\0' && len < KEY_LENGTH - 1)
+	{
+		if (isdigit((unsigned char)*str))
+		{
+			while (*str == '0' && isdigit((unsigned char)str[1]))
+				str++;
+
+			int digits = 0;
+			while (isdigit((unsigned char)str[digits]))
+				digits++;
+
+			if (len + digits + 1 >= KEY_LENGTH)
+				break;
+
+			out[len++] = '0' + (digits < 40 ? digits : 40);
+			memcpy(out + len, str, digits);
+
+			len += digits;
+			str += digits;
+		}
+		else
+		{
+			out[len++] = tolower((unsigned char)*str++);
+		}
+	}
+
+	out[len] = '\0';
+}
+
+//packs up to count bytes of str big-endian below the folder bit
+static u64 _packPrefix(u64 prefix, char const* str, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		prefix <<= 8;
+
+		if (*str != '\0')
+			prefix |= (u8)*str++;
+	}
+
+	return prefix;
+}
+
+//folders and files are grouped apart, sorted modes list every folder first
+static int _jumpGroup(u64 prefix, bool directory)
+{
+	//the first byte below the folder bit is the first byte of the name, title or game code
+	int c = toupper((int)((prefix >> 48) & 0xFF));
+	int letter = (c >= 'A' && c <= 'Z') ? 1 + (c - 'A') : 0;
+
+	return directory ? letter : LETTER_COUNT + letter;
+}
+
+//records entry i as a jump point if it starts a new group, i has to come in sorted order
+static bool _addJump(u32 i, u64 prefix, bool directory)
+{
+	//sizes and folder order have no letters to jump between
+	if (listSort == SORT_SIZE || listSort == SORT_NONE)
+		return true;
+
+	int group = _jumpGroup(prefix, directory);
+	if (group == lastGroup)
+		return true;
+
+	if (!_reserve((void**)&jumps, &jumpCap, jumpCount + 1, sizeof(u32)))
+		return false;
+
+	jumps[jumpCount++] = i;
+	lastGroup = group;
+	return true;
+}
+
+//reads what the sort mode needs out of a rom header and banner
+static void _readRomKey(char const* path, int sort, char* key, sNDSBannerExt* banner)
+{
+	key[0] = '\0';
+
+	FILE* f = fopen(path, "rb");
+	if (!f) return;
+
+	tNDSHeader h;
+	if (fread(&h, sizeof(tNDSHeader), 1, f) == 1)
+	{
+		if (sort == SORT_CODE)
+		{
+			sprintf(key, "%.4s", h.gameCode);
+		}
+		else if (sort == SORT_TITLE && banner)
+		{
+			memset(banner, 0, sizeof(sNDSBannerExt));
+
+			if (h.bannerOffset != 0 &&
+				fseek(f, h.bannerOffset, SEEK_SET) == 0 &&
+				fread(banner, NDS_BANNER_SIZE_ZH_KO, 1, f) == 1)
+			{
+				char title[128+1];
+				getGameTitle(banner, title, false);
+				_naturalKey(title, key);
+			}
+		}
+	}
+
+	fclose(f);
+}
+
+static bool _addEntry(char const* dirPath, char const* name, bool directory, int sort, sNDSBannerExt* banner)
+{
+	if (!_reserve((void**)&entries, &entryCap, entryCount + 1, sizeof(DirEntry)))
+		return false;
+
+	DirEntry* e = &entries[entryCount];
+	e->directory = directory;
+	e->size = 0;
+	e->name = _addString(name);
+	e->key = e->name;
+	e->prefix = 0;
+
+	if (e->name == NO_STRING)
+		return false;
+
+	if (sort != SORT_NONE)
+	{
+		char nameKey[KEY_LENGTH];
+		char romKey[KEY_LENGTH] = "";
+		_naturalKey(name, nameKey);
+
+		//metadata only exists for files
+		if (!directory && (sort == SORT_TITLE || sort == SORT_CODE || sort == SORT_SIZE))
+		{
+			char path[512];
+			snprintf(path, sizeof(path), "%s/%s", dirPath, name);
+
+			if (sort == SORT_SIZE)
+			{
+				struct stat st;
+				if (stat(path, &st) == 0)
+					e->size = st.st_size;
+			}
+			else
+			{
+				_readRomKey(path, sort, romKey, banner);
+			}
+		}
+
+		u64 prefix = directory ? 0 : PREFIX_FILE;
+
+		switch (sort)
+		{
+			case SORT_TITLE:
+				//files without a title fall back to their name
+				if (romKey[0] == '\0')
+					sprintf(romKey, "%s", nameKey);
+
+				e->key = _addString(romKey);
+				prefix |= _packPrefix(0, romKey, 7);
+				break;
+
+			case SORT_CODE:
+				e->key = _addString(nameKey);
+				prefix |= _packPrefix(_packPrefix(0, romKey, 4), nameKey, 3);
+				break;
+
+			case SORT_SIZE:
+				e->key = _addString(nameKey);
+				prefix |= e->size;
+				break;
+
+			default:
+				e->key = _addString(nameKey);
+				prefix |= _packPrefix(0, nameKey, 7);
+				break;
+		}
+
+		e->prefix = prefix;
+
+		if (e->key == NO_STRING)
+			return false;
+	}
+
+	entryCount += 1;
+	return true;
+}
+
+//LSD radix sort on the prefix, bytes every entry shares are skipped
+static bool _radixSort()
+{
+	DirEntry* tmp = (DirEntry*)malloc(entryCount * sizeof(DirEntry));
+	if (!tmp) return false;
+
+	DirEntry* src = entries;
+	DirEntry* dst = tmp;
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		u32 counts[256] = {0};
+
+		for (u32 i = 0; i < entryCount; i++)
+			counts[(src[i].prefix >> shift) & 0xFF] += 1;
+
+		if (counts[(src[0].prefix >> shift) & 0xFF] == entryCount)
+			continue;
+
+		u32 offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			u32 count = counts[b];
+			counts[b] = offset;
+			offset += count;
+		}
+
+		for (u32 i = 0; i < entryCount; i++)
+			dst[counts[(src[i].prefix >> shift) & 0xFF]++] = src[i];
+
+		DirEntry* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != entries)
+		memcpy(entries, src, entryCount * sizeof(DirEntry));
+
+	free(tmp);
+	return true;
+}
+
+//entries with equal prefixes are almost always few, insertion sort them on the full key
+static void _sortTies()
+{
+	u32 start = 0;
+
+	while (start < entryCount)
+	{
+		u32 end = start + 1;
+		while (end < entryCount && entries[end].prefix == entries[start].prefix)
+			end++;
+
+		for (u32 i = start + 1; i < end; i++)
+		{
+			DirEntry e = entries[i];
+			u32 j = i;
+
+			while (j > start && strcmp(pool + entries[j-1].key, pool + e.key) > 0)
+			{
+				entries[j] = entries[j-1];
+				j--;
+			}
+
+			entries[j] = e;
+		}
+
+		start = end;
+	}
+}
+
+static bool _spillRun(int sort)
+{
+	if (runCount >= MAX_RUNS)
+		return false;
+
+	if (!runFile)
+	{
+		mkdir(APP_DATA_ROOT, 0777);
+		mkdir(APP_DATA_DIR, 0777);
+
+		runFile = fopen(RUNS_PATH, "w+b");
+		if (!runFile) return false;
+
+		runStart[0] = 0;
+	}
+
+	if (sort == SORT_NONE)
+	{
+		//the merge keeps the order the folder was read in
+		for (u32 i = 0; i < entryCount; i++)
+			entries[i].prefix = totalCount + i;
+	}
+
+	else if (entryCount > 1)
+	{
+		if (!_radixSort())
+			return false;
+
+		_sortTies();
+	}
+
+	u32 offset = runStart[runCount];
+	fseek(runFile, offset, SEEK_SET);
+
+	for (u32 i = 0; i < entryCount; i++)
+	{
+		RunRecord r;
+		r.prefix = entries[i].prefix;
+		r.keyLength = strlen(pool + entries[i].key) + 1;
+		r.nameLength = strlen(pool + entries[i].name) + 1;
+		r.directory = entries[i].directory;
+
+		if (fwrite(&r, sizeof(r), 1, runFile) != 1 ||
+			fwrite(pool + entries[i].key, 1, r.keyLength, runFile) != r.keyLength ||
+			fwrite(pool + entries[i].name, 1, r.nameLength, runFile) != r.nameLength)
+			return false;
+
+		offset += sizeof(r) + r.keyLength + r.nameLength;
+	}
+
+	//the spill files take SD space out of the install ledger
+	sdLedgerResize(runStart[runCount], offset);
+
+	runCount += 1;
+	runStart[runCount] = offset;
+	totalCount += entryCount;
+
+	//the arrays are reused for the next run
+	entryCount = 0;
+	poolSize = 0;
+
+	return true;
+}
+
+static bool _runRead(RunReader* r, void* dst, u32 len)
+{
+	u8* out = (u8*)dst;
+
+	while (len > 0)
+	{
+		if (r->bufPos >= r->bufLen)
+		{
+			if (r->pos >= r->end)
+				return false;
+
+			u32 toRead = r->end - r->pos;
+			if (toRead > RUN_BUFFER)
+				toRead = RUN_BUFFER;
+
+			fseek(runFile, r->pos, SEEK_SET);
+			if (fread(r->buffer, 1, toRead, runFile) != toRead)
+				return false;
+
+			r->pos += toRead;
+			r->bufPos = 0;
+			r->bufLen = toRead;
+		}
+
+		u32 count = r->bufLen - r->bufPos;
+		if (count > len)
+			count = len;
+
+		memcpy(out, r->buffer + r->bufPos, count);
+		r->bufPos += count;
+		out += count;
+		len -= count;
+	}
+
+	return true;
+}
+
+static bool _runNext(RunReader* r)
+{
+	if (!_runRead(r, &r->head, sizeof(RunRecord)))
+		return false;
+
+	if (r->head.keyLength > KEY_LENGTH || r->head.nameLength > NAME_LENGTH)
+		return false;
+
+	return _runRead(r, r->key, r->head.keyLength) &&
+		   _runRead(r, r->name, r->head.nameLength);
+}
+
+static bool _runLess(int a, int b)
+{
+	if (runs[a].head.prefix != runs[b].head.prefix)
+		return runs[a].head.prefix < runs[b].head.prefix;
+
+	return strcmp(runs[a].key, runs[b].key) < 0;
+}
+
+static void _heapDown(int i)
+{
+	while (1)
+	{
+		int smallest = i;
+		int left = 2 * i + 1;
+		int right = left + 1;
+
+		if (left < heapSize && _runLess(heap[left], heap[smallest]))
+			smallest = left;
+
+		if (right < heapSize && _runLess(heap[right], heap[smallest]))
+			smallest = right;
+
+		if (smallest == i)
+			break;
+
+		int swap = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = swap;
+		i = smallest;
+	}
+}
+
+static bool _mergeInit()
+{
+	runs = (RunReader*)malloc(runCount * sizeof(RunReader));
+	heap = (int*)malloc(runCount * sizeof(int));
+	windowNames = (char (*)[NAME_LENGTH])malloc(WINDOW * NAME_LENGTH);
+	mergeFile = fopen(MERGE_PATH, "w+b");
+
+	if (!runs || !heap || !windowNames || !mergeFile)
+		return false;
+
+	fflush(runFile);
+
+	heapSize = 0;
+
+	for (int i = 0; i < runCount; i++)
+	{
+		runs[i].pos = runStart[i];
+		runs[i].end = runStart[i+1];
+		runs[i].bufPos = 0;
+		runs[i].bufLen = 0;
+
+		if (_runNext(&runs[i]))
+			heap[heapSize++] = i;
+	}
+
+	for (int i = heapSize / 2 - 1; i >= 0; i--)
+		_heapDown(i);
+
+	mergedCount = 0;
+	mergeEnd = 0;
+	mergeCharged = 0;
+	windowCount = 0;
+
+	return true;
+}
+
+//moves the smallest head of all runs to the end of the merge file
+static bool _mergeNext()
+{
+	if (heapSize <= 0)
+		return false;
+
+	RunReader* r = &runs[heap[0]];
+
+	if (mergedCount % WINDOW == 0)
+	{
+		u32 chunk = mergedCount / WINDOW;
+
+		if (!_reserve((void**)&chunkOffsets, &chunkCap, chunk + 1, sizeof(u32)))
+			return false;
+
+		chunkOffsets[chunk] = mergeEnd;
+
+		//charged a chunk at a time
+		sdLedgerResize(mergeCharged, mergeEnd);
+		mergeCharged = mergeEnd;
+	}
+
+	u8 directory = r->head.directory;
+	u16 nameLength = r->head.nameLength;
+
+	fseek(mergeFile, mergeEnd, SEEK_SET);
+	if (fwrite(&directory, 1, 1, mergeFile) != 1 ||
+		fwrite(&nameLength, sizeof(u16), 1, mergeFile) != 1 ||
+		fwrite(r->name, 1, nameLength, mergeFile) != nameLength)
+		return false;
+
+	mergeEnd += 1 + sizeof(u16) + nameLength;
+
+	if (!_addJump(mergedCount, r->head.prefix, r->head.directory))
+		return false;
+
+	mergedCount += 1;
+
+	if (!_runNext(r))
+		heap[0] = heap[--heapSize];
+
+	_heapDown(0);
+	return true;
+}
+
+static void _mergeUntil(u32 count)
+{
+	while (mergedCount < count && _mergeNext());
+}
+
+static bool _loadWindow(u32 i)
+{
+	u32 start = i - (i % WINDOW);
+
+	_mergeUntil(start + WINDOW);
+	if (start >= mergedCount)
+		return false;
+
+	fflush(mergeFile);
+	fseek(mergeFile, chunkOffsets[start / WINDOW], SEEK_SET);
+
+	windowStart = start;
+	windowCount = 0;
+
+	while (windowCount < WINDOW && start + windowCount < mergedCount)
+	{
+		u8 directory;
+		u16 nameLength;
+
+		if (fread(&directory, 1, 1, mergeFile) != 1 ||
+			fread(&nameLength, sizeof(u16), 1, mergeFile) != 1 ||
+			nameLength > NAME_LENGTH ||
+			fread(windowNames[windowCount], 1, nameLength, mergeFile) != nameLength)
+			break;
+
+		windowDirs[windowCount] = directory;
+		windowCount += 1;
+	}
+
+	return (i - windowStart < windowCount);
+}
+
+static bool _finish()
+{
+	closedir(listDir);
+	free(listBanner);
+
+	listDir = NULL;
+	listBanner = NULL;
+	listing = false;
+
+	if (spilled)
+	{
+		bool result = (entryCount == 0 || _spillRun(listSort)) && _mergeInit();
+
+		//only the merge state is kept in memory from here on
+		free(entries);
+		free(pool);
+
+		entries = NULL;
+		pool = NULL;
+
+		entryCap = 0;
+		poolCap = 0;
+
+		return result;
+	}
+
+	//without room for the sort buffer the folder is still listed, just unsorted
+	if (listSort != SORT_NONE && entryCount > 1 && _radixSort())
+		_sortTies();
+
+	//without room for the jump points L and R just don't jump
+	for (u32 i = 0; i < entryCount; i++)
+	{
+		if (!_addJump(i, entries[i].prefix, entries[i].directory))
+			break;
+	}
+
+	return true;
+}
+
+bool dirListOpen(char const* path, int sort)
+{
+	dirListFree();
+
+	listDir = opendir(path[0] == '\0' ? "/" : path);
+	if (!listDir) return false;
+
+	snprintf(listPath, sizeof(listPath), "%s", path);
+	listSort = sort;
+	listing = true;
+
+	if (sort == SORT_TITLE)
+		listBanner = (sNDSBannerExt*)malloc(sizeof(sNDSBannerExt));
+
+	return true;
+}
+
+bool dirListStep(u32 ticks)
+{
+	if (!listing) return false;
+
+	const u32 runEntries = isDSiMode() ? RUN_ENTRIES_DSI : RUN_ENTRIES_DS;
+
+	bool result = true;
+	bool finished = false;
+	struct dirent* ent;
+
+	//the timer number doesn't matter, libnds has only one for timing so spans must not nest
+	cpuStartTiming(0);
+
+	do
+	{
+		ent = readdir(listDir);
+
+		if (!ent)
+		{
+			finished = true;
+			break;
+		}
+
+		if (strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
+			continue;
+
+		bool directory = (ent->d_type == DT_DIR);
+
+		if (!directory && !isRomFile(ent->d_name))
+			continue;
+
+		if (entryCount >= runEntries)
+		{
+			result = _spillRun(listSort);
+			spilled = true;
+		}
+
+		if (result)
+			result = _addEntry(listPath, ent->d_name, directory, listSort, listBanner);
+	}
+	while (result && (ticks == 0 || cpuGetTiming() < ticks));
+
+	cpuEndTiming();
+
+	if (result && finished)
+		result = _finish();
+
+	if (!result)
+	{
+		dirListFree();
+		return false;
+	}
+
+	return listing;
+}
+
+bool dirListBusy()
+{
+	return listing;
+}
+
+//a spilled folder is only in order once it has all been read, its names wait until then
+bool dirListSpilled()
+{
+	return spilled;
+}
+
+void dirListFree()
+{
+	if (listDir)
+		closedir(listDir);
+
+	free(listBanner);
+
+	listDir = NULL;
+	listBanner = NULL;
+	listing = false;
+
+	free(entries);
+	free(pool);
+
+	entries = NULL;
+	pool = NULL;
+
+	entryCount = entryCap = 0;
+	poolSize = poolCap = 0;
+
+	//removing the spill files gives their SD space back
+	if (runFile)
+	{
+		fclose(runFile);
+		remove(RUNS_PATH);
+		sdLedgerResize(runStart[runCount], 0);
+	}
+
+	if (mergeFile)
+	{
+		fclose(mergeFile);
+		remove(MERGE_PATH);
+		sdLedgerResize(mergeCharged, 0);
+	}
+
+	free(runs);
+	free(heap);
+	free(chunkOffsets);
+	free(windowNames);
+	free(jumps);
+
+	runFile = NULL;
+	mergeFile = NULL;
+	runs = NULL;
+	heap = NULL;
+	chunkOffsets = NULL;
+	windowNames = NULL;
+	jumps = NULL;
+
+	spilled = false;
+	runCount = 0;
+	heapSize = 0;
+	chunkCap = 0;
+	totalCount = 0;
+	mergedCount = 0;
+	mergeEnd = 0;
+	mergeCharged = 0;
+	windowStart = 0;
+	windowCount = 0;
+	jumpCount = 0;
+	jumpCap = 0;
+	lastGroup = -1;
+}
+
+int dirListCount()
+{
+	return totalCount + entryCount;
+}
+
+//while the folder is still being read only an unspilled first run can be shown
+char const* dirListName(int i)
+{
+	if (i < 0 || i >= dirListCount())
+		return NULL;
+
+	if (!spilled)
+		return pool + entries[i].name;
+
+	if (listing)
+		return NULL;
+
+	if (i < windowStart || i >= windowStart + windowCount)
+	{
+		if (!_loadWindow(i))
+			return NULL;
+	}
+
+	return windowNames[i - windowStart];
+}
+
+bool dirListIsDir(int i)
+{
+	if (i < 0 || i >= dirListCount())
+		return false;
+
+	if (!spilled)
+		return entries[i].directory;
+
+	if (listing)
+		return false;
+
+	if (i < windowStart || i >= windowStart + windowCount)
+	{
+		if (!_loadWindow(i))
+			return false;
+	}
+
+	return windowDirs[i - windowStart];
+}
+
+//first entry of the group before or after the one holding entry i, -1 if there is none
+int dirListJump(int i, int dir)
+{
+	if (listing || i < 0 || i >= dirListCount())
+		return -1;
+
+	if (spilled)
+		_mergeUntil(i + 1);
+
+	if (jumpCount == 0)
+		return -1;
+
+	//a spilled folder only knows the groups merged so far, merge on until the next one starts
+	if (spilled && dir > 0)
+	{
+		while (jumps[jumpCount-1] <= i && _mergeNext());
+	}
+
+	int group = 0;
+	while (group + 1 < jumpCount && jumps[group+1] <= i)
+		group++;
+
+	group += (dir > 0) ? 1 : -1;
+
+	if (group < 0 || group >= jumpCount)
+		return -1;
+
+	return jumps[group];
+}
@@ -24,10 +24,13 @@
 #include <nds.h>
 
 #include "sav.h"
+#include "crc16.h"
 #include "main.h"
 #include "message.h"
 #include "maketmd.h"
+#include "nitrofs.h"
 #include "rom.h"
+#include "sha1.h"
 #include "storage.h"
 
 // hardcode the only two constants. This may be changed one day, will just release a new one at that point anyway
@@ -40,10 +43,8 @@ static bool _titleIsUsed(tDSiHeader* h)
 {
 	if (!h) return false;
 
-	char path[64];
-	sprintf(path, "/title/%08x/%08x/", (unsigned int)h->tid_high, (unsigned int)h->tid_low);
-
-	return dirExists(path);
+	//in memory, so randomizing a game code costs no folder lookups per try
+	return titleExists(h->tid_high, h->tid_low);
 }
 
 // randomize TID
@@ -95,12 +96,13 @@ static bool _iqueHack(tDSiHeader* h)
 	return false;
 }
 
-static bool _checkSdSpace(unsigned long long size)
+//reserves every file the install will write, each rounded to a cluster
+static bool _checkSdSpace(unsigned long long const* sizes, int count)
 {
 	iprintf("Enough room on SD card?...");
 	swiWaitForVBlank();
 
-	if (getSDCardFree() < size)
+	if (!sdReserve(sizes, count))
 	{
 		iprintf("\x1B[31m");	//red
 		iprintf("No\n");
@@ -141,16 +143,43 @@ bool installError(char* error)
 	iprintf("%s", error);
 	iprintf("\x1B[47m");	//white
 	
+	//what was reserved stays taken, a half written install never uses more than that
+	storageStatsInvalidate();
+
 	messagePrint("\x1B[31m\nInstallation failed.\n\x1B[47m");
 	return false;
 }
 
+//crc of the last template extracted, tells template builds apart in the tmd cache
+static u16 templateCrc = 0xFFFF;
+
+static void _crcTemplate(void* ctx, const void* data, size_t len)
+{
+	*(u16*)ctx = crc16(*(u16*)ctx, data, len);
+}
+
+//copies a template out of nitrofs in one go, without a file handle on the nitro side
+static bool _extractTemplate(char const* src, char const* templatePath)
+{
+	if (!mountNitroFS()) return false;
+
+	FILE* f = fopen(templatePath, "wb");
+	if (!f) return false;
+
+	templateCrc = 0xFFFF;
+	ssize_t size = nitroFSExport(src, f, _crcTemplate, &templateCrc);
+	fclose(f);
+
+	return size > 0;
+}
+
 static bool _generateFcForwarder(char* fpath, char* templatePath)
 {
 	// extract template
 	mkdir("/_nds", 0777);
 	remove(templatePath);
-	copyFile("nitro:/flashcard.nds", templatePath);
+	if (!_extractTemplate("nitro:/flashcard.nds", templatePath))
+		return installError("Failed to extract template.\n");
 	iprintf("Template copied to SD.\n");
 
 	tDSiHeader* templateheader = getRomHeader(templatePath);
@@ -160,7 +189,7 @@ static bool _generateFcForwarder(char* fpath, char* templatePath)
 
 
 	// header operations
-	if(swiCRC16(0xFFFF, targetheader, 0x15E) != targetheader->headerCRC16) {
+	if(crc16(0xFFFF, targetheader, 0x15E) != targetheader->headerCRC16) {
 		free(targetheader);
 		free(templateheader);
 		return installError("Header CRC check failed. This ROM may be corrupt.\n");
@@ -208,7 +237,8 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 	// extract template
 	mkdir("/_nds", 0777);
 	remove(templatePath);
-	copyFile("nitro:/sdcard.nds", templatePath);
+	if (!_extractTemplate("nitro:/sdcard.nds", templatePath))
+		return installError("Failed to extract template.\n");
 	iprintf("Template copied to SD.\n");
 
 	// DSiWare check
@@ -231,7 +261,7 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 
 
 	// header operations
-	if(swiCRC16(0xFFFF, targetheader, 0x15E) != targetheader->headerCRC16) {
+	if(crc16(0xFFFF, targetheader, 0x15E) != targetheader->headerCRC16) {
 		free(targetheader);
 		free(templateheader);
 		return installError("Header CRC check failed. This ROM may be corrupt.\n");
@@ -240,7 +270,7 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 	memcpy(templateheader->ndshdr.gameTitle, targetheader->gameTitle, 12);
 	memcpy(templateheader->ndshdr.gameCode, targetheader->gameCode, 4);
 	templateheader->tid_low = __builtin_bswap32((*(u32*)targetheader->gameCode));
-	templateheader->ndshdr.headerCRC16 = swiCRC16(0xFFFF, &templateheader->ndshdr, 0x15E);
+	templateheader->ndshdr.headerCRC16 = crc16(0xFFFF, &templateheader->ndshdr, 0x15E);
 	free(targetheader);
 
 	// banner operations
@@ -251,13 +281,13 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 	bool crccheck = true;
 	switch(targetbanner->version) {
 		case NDS_BANNER_VER_ZH_KO:
-			if(swiCRC16(0xFFFF, &targetbanner->icon, 0xA20) != targetbanner->crc[2]) crccheck = false;
+			if(crc16(0xFFFF, &targetbanner->icon, 0xA20) != targetbanner->crc[2]) crccheck = false;
 			break;
 		case NDS_BANNER_VER_ZH:
-			if(swiCRC16(0xFFFF, &targetbanner->icon, 0x920) != targetbanner->crc[1]) crccheck = false;
+			if(crc16(0xFFFF, &targetbanner->icon, 0x920) != targetbanner->crc[1]) crccheck = false;
 			break;
 		case NDS_BANNER_VER_ORIGINAL:
-			if(swiCRC16(0xFFFF, &targetbanner->icon, 0x820) != targetbanner->crc[0]) crccheck = false;
+			if(crc16(0xFFFF, &targetbanner->icon, 0x820) != targetbanner->crc[0]) crccheck = false;
 			break;
 	}
 	if (!crccheck) {
@@ -272,7 +302,7 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 		case NDS_BANNER_VER_ZH:
 			memcpy(targetbanner->titles[7], targetbanner->titles[1], 0x100);
 		default:
-			u16 crcDSi = swiCRC16(0xFFFF, &targetbanner->dsi_icon, 0x1180);
+			u16 crcDSi = crc16(0xFFFF, &targetbanner->dsi_icon, 0x1180);
 			if(targetbanner->version != NDS_BANNER_VER_DSi || crcDSi != targetbanner->crc[3]) {
 				memset(targetbanner->reserved2, 0xFF, sizeof(targetbanner->reserved2));
 				memset(targetbanner->dsi_icon, 0xFF, sizeof(targetbanner->dsi_icon));
@@ -282,9 +312,9 @@ static bool _generateForwarder(char* fpath, char* templatePath)
 				targetbanner->crc[3] = 0x0000;
 				targetbanner->version = NDS_BANNER_VER_ZH_KO;
 			} else targetbanner->crc[3] = crcDSi;
-			targetbanner->crc[0] = swiCRC16(0xFFFF, &targetbanner->icon, 0x820);
-			targetbanner->crc[1] = swiCRC16(0xFFFF, &targetbanner->icon, 0x920);
-			targetbanner->crc[2] = swiCRC16(0xFFFF, &targetbanner->icon, 0xA20);
+			targetbanner->crc[0] = crc16(0xFFFF, &targetbanner->icon, 0x820);
+			targetbanner->crc[1] = crc16(0xFFFF, &targetbanner->icon, 0x920);
+			targetbanner->crc[2] = crc16(0xFFFF, &targetbanner->icon, 0xA20);
 			break;
 	}
 
@@ -353,7 +383,7 @@ bool installFc(char* fpath)
 		printBytes(fileSize);
 		iprintf("\n");
 
-		if (!_checkSdSpace(fileSize)) return installError("Not enough space on SD.\n");
+		if (!_checkSdSpace(&fileSize, 1)) return installError("Not enough space on SD.\n");
 
 		//system title patch
 
@@ -375,6 +405,7 @@ bool installFc(char* fpath)
 			{
 				iprintf("\nDeleting:\n");
 				deleteDir(newPath);
+				storageStatsInvalidate();
 				iprintf("\n");
 			}
 		}
@@ -388,6 +419,7 @@ bool installFc(char* fpath)
 				//copy nds file to forwarder folder
 				{
 					int result = copyFile(templatePath, newPath);
+					storageStatsInvalidate();
 
 					if (result != 0)
 					{
@@ -474,7 +506,18 @@ bool install(char* fpath, bool randomize)
 		printBytes(fileSize);
 		iprintf("\n");
 
-		if (!_checkSdSpace(fileSize)) return installError("Not enough space on SD.\n");
+		//the app, with the banner padding added below, and its TMD
+		{
+			unsigned long long sizes[2] = {
+				fileSize,
+				TMD_SIZE
+			};
+
+			if (h->ndshdr.bannerOffset == fileSize - 0x1C00)
+				sizes[0] += 0x7C0;
+
+			if (!_checkSdSpace(sizes, 2)) return installError("Not enough space on SD.\n");
+		}
 
 		//system title patch
 
@@ -502,6 +545,7 @@ bool install(char* fpath, bool randomize)
 			{
 				iprintf("\nDeleting:\n");
 				deleteDir(dirPath);
+				titleRemoved(h->tid_high, h->tid_low);
 				iprintf("\n");
 			}
 		}
@@ -572,32 +616,34 @@ bool install(char* fpath, bool randomize)
 						swiWaitForVBlank();
 
 						//fix header checksum
-						h->ndshdr.headerCRC16 = swiCRC16(0xFFFF, h, 0x15E);
+						h->ndshdr.headerCRC16 = crc16(0xFFFF, h, 0x15E);
 
 						//fix RSA signature
-						u8 buffer[20];
-						swiSHA1Calc(&buffer, h, 0xE00);
+						u8 buffer[SHA1_DIGEST_LENGTH];
+						sha1Calc(buffer, h, 0xE00);
 						memcpy(&(h->rsa_signature[0x6C]), buffer, 20);
 
+						//the app can't boot with the template's header, so a failed write ends the install
 						FILE* f = fopen(appPath, "r+");
+						bool written = false;
 
-						if (!f)
+						if (f)
 						{
-							iprintf("\x1B[31m");	//red
-							iprintf("Failed\n");
-							iprintf("\x1B[47m");	//white
+							written = (fseek(f, 0, SEEK_SET) == 0 && fwrite(h, sizeof(tDSiHeader), 1, f) == 1);
+							written = (fclose(f) == 0) && written;
 						}
-						else
-						{
-							fseek(f, 0, SEEK_SET);
-							fwrite(h, sizeof(tDSiHeader), 1, f);
 
-							iprintf("\x1B[42m");	//green
-							iprintf("Done\n");
+						if (!written)
+						{
+							iprintf("\x1B[31m");	//red
+							iprintf("Failed\n");
 							iprintf("\x1B[47m");	//white
+							return installError("Failed to write the header.\n");
 						}
 
-						fclose(f);
+						iprintf("\x1B[42m");	//green
+						iprintf("Done\n");
+						iprintf("\x1B[47m");	//white
 					}
 				}
 
@@ -606,8 +652,36 @@ bool install(char* fpath, bool randomize)
 					char tmdPath[80];
 					sprintf(tmdPath, "%s/title.tmd", contentPath);
 
-					if (maketmd(appPath, tmdPath) != 0)				
+					//an app built from the same template, header, banner and path as before reuses its hash
+					TmdKey key;
+					memset(&key, 0, sizeof(key));
+					key.tidLow = h->tid_low;
+					key.tidHigh = h->tid_high;
+					key.templateCrc = templateCrc;
+					key.pathHash = tmdPathHash(fpath, gamepath_length);
+
+					//the header as the app holds it, not as patched in memory
+					tDSiHeader* appHeader = getRomHeader(appPath);
+					sNDSBannerExt* banner = getRomBanner(appPath);
+					bool keyed = (appHeader != NULL && banner != NULL);
+
+					if (appHeader)
+					{
+						key.headerCrc = crc16(0xFFFF, appHeader, sizeof(tDSiHeader));
+						free(appHeader);
+					}
+
+					if (banner)
+					{
+						memcpy(key.bannerCrc, banner->crc, sizeof(key.bannerCrc));
+						free(banner);
+					}
+
+					if (maketmdCached(appPath, tmdPath, keyed ? &key : NULL) != 0)
 						return installError("Failed to generate TMD.\n");
+
+					//only a title with its app and TMD in place counts as installed
+					titleAdded(h->tid_high, h->tid_low);
 				}
 			}
 		}
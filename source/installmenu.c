@@ -18,7 +18,6 @@
 */
 
 #include <stdio.h>
-#include <dirent.h>
 
 #include <nds.h>
 
@@ -28,6 +27,7 @@
 #include "menu.h"
 #include "storage.h"
 #include "message.h"
+#include "dirlist.h"
 
 enum {
 	INSTALL_MENU_INSTALL,
@@ -35,12 +35,46 @@ enum {
 	INSTALL_MENU_BACK
 };
 
+//time each frame may spend reading a big folder, in cpuGetTiming() ticks
+#define LIST_STEP_TICKS (BUS_CLOCK / 100)
+
 static char currentDir[512] = "";
 
+static bool listIndexed = false;
+static int sortMode = SORT_NAME;
+
 static void generateList(Menu* m);
 static void printItem(Menu* m);
 static int subMenu();
 
+//L and R jump to the first entry of the previous or next leading letter of the sort key,
+//folders and files are jumped through separately
+static bool _jumpLetter(Menu* m)
+{
+	if (!m) return false;
+	if (m->itemCount <= 0) return false;
+
+	int dir = 0;
+
+	if (keysDown() & KEY_R)
+		dir = 1;
+
+	else if (keysDown() & KEY_L)
+		dir = -1;
+
+	else
+		return false;
+
+	return jumpCursor(m, dirListJump(m->page * ITEMS_PER_PAGE + m->cursor, dir));
+}
+
+//shown instead of a page while a spilled folder is still being read
+static void _printProgress()
+{
+	consoleSelect(&bottomScreen);
+	iprintf("\x1b[4;0HReading folder... %d", dirListCount());
+}
+
 static void _setHeader(Menu* m)
 {
 	if (!m) return;
@@ -54,6 +88,7 @@ void installMenu()
 {
 	Menu* m = newMenu();
 	_setHeader(m);
+	listIndexed = false;
 	generateList(m);
 
 	//no files found
@@ -73,9 +108,20 @@ void installMenu()
 		while (1)
 		{
 			swiWaitForVBlank();
+
+			//keep reading the folder in the time left in each frame
+			if (dirListBusy())
+			{
+				if (!dirListStep(LIST_STEP_TICKS))
+					generateList(m);
+
+				else if (m->itemCount <= 0)
+					_printProgress();
+			}
+
 			scanKeys();
 
-			if (moveCursor(m))
+			if (moveCursor(m) || _jumpLetter(m))
 			{
 				if (m->changePage != 0)
 					generateList(m);
@@ -94,6 +140,7 @@ void installMenu()
 					*ptr = '\0';
 					_setHeader(m);
 					resetMenu(m);
+					listIndexed = false;
 					generateList(m);
 					printMenu(m);
 				}
@@ -106,6 +153,15 @@ void installMenu()
 			else if (keysDown() & KEY_X)
 				break;
 
+			//sort mode
+			else if (keysDown() & KEY_Y)
+			{
+				sortMode = (sortMode + 1) % SORT_COUNT;
+				resetMenu(m);
+				listIndexed = false;
+				generateList(m);
+			}
+
 			//selection
 			else if (keysDown() & KEY_A)
 			{
@@ -114,21 +170,7 @@ void installMenu()
 					if (m->items[m->cursor].directory == false)
 					{
 						//nds file
-						switch (subMenu())
-						{
-							case INSTALL_MENU_INSTALL:
-								install(m->items[m->cursor].value, false);
-								break;
-
-							case INSTALL_MENU_RANDOMIZE:
-								if (isDSiMode()) {
-									install(m->items[m->cursor].value, true);
-								}
-								break;
-
-							case INSTALL_MENU_BACK:					
-								break;
-						}
+						installPrompt(m->items[m->cursor].value);
 					}
 					else
 					{
@@ -136,6 +178,7 @@ void installMenu()
 						sprintf(currentDir, "%s", m->items[m->cursor].value);
 						_setHeader(m);
 						resetMenu(m);
+						listIndexed = false;
 						generateList(m);
 					}
 
@@ -146,6 +189,7 @@ void installMenu()
 	}
 
 	freeMenu(m);
+	dirListFree();
 }
 
 static void generateList(Menu* m)
@@ -155,85 +199,52 @@ static void generateList(Menu* m)
 	//reset menu
 	clearMenu(m);
 
-	m->page += sign(m->changePage);
+	m->page += m->changePage;
 	m->changePage = 0;
 
-	bool done = false;
+	//a fresh folder is read and sorted once, pages are then served from the snapshot
+	if (!listIndexed)
+	{
+		dirListOpen(currentDir, sortMode);
+		listIndexed = true;
+	}
 
-	struct dirent* ent;
-	DIR* dir = NULL;
+	//only wait for the entries this page shows, the rest is read between frames
+	const int needed = (m->page + 1) * ITEMS_PER_PAGE + 1;
 
-	if (currentDir[0] == '\0')
-		dir = opendir("/");
-	else
-		dir = opendir(currentDir);	
+	while (dirListBusy() && !dirListSpilled() && dirListCount() < needed)
+		dirListStep(LIST_STEP_TICKS);
 
-	if (dir)
+	//a folder too big to sort in memory has no first page until it's all read, show how far it got
+	if (dirListBusy() && dirListSpilled())
 	{
-		int count = 0;
+		m->itemTotal = 0;
+		m->nextPage = false;
+		m->cursor = 0;
 
-		//scan /dsi/
-		while ( (ent = readdir(dir)) && !done)
-		{
-			if (strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
-				continue;
+		clearScreen(&topScreen);
+		printMenu(m);
+		_printProgress();
+		return;
+	}
 
-			if (ent->d_type == DT_DIR)
-			{
-				if (count < m->page * ITEMS_PER_PAGE)
-						count += 1;
-			
-				else
-				{
-					if (m->itemCount >= ITEMS_PER_PAGE)
-						done = true;
-					
-					else
-					{
-						char* fpath = (char*)malloc(strlen(currentDir) + strlen(ent->d_name) + 8);
-						sprintf(fpath, "%s/%s", currentDir, ent->d_name);
+	//until then the total is unknown and the cursor moves a page at a time
+	m->itemTotal = dirListBusy() ? 0 : dirListCount();
 
-						addMenuItem(m, ent->d_name, fpath, 1);
-					}
-				}
-			}
-			else
-			{
-				if (strstr(ent->d_name, ".nds") != NULL ||
-					strstr(ent->d_name, ".ids") != NULL ||
-					strstr(ent->d_name, ".app") != NULL ||
-					strstr(ent->d_name, ".dsi") != NULL ||
-					strstr(ent->d_name, ".NDS") != NULL ||
-					strstr(ent->d_name, ".APP") != NULL ||
-					strstr(ent->d_name, ".DSI") != NULL ||
-					strstr(ent->d_name, ".IDS") != NULL)
-				{
-					if (count < m->page * ITEMS_PER_PAGE)
-						count += 1;
-					
-					else
-					{
-						if (m->itemCount >= ITEMS_PER_PAGE)
-							done = true;
-						
-						else
-						{
-							char* fpath = (char*)malloc(strlen(currentDir) + strlen(ent->d_name) + 8);
-							sprintf(fpath, "%s/%s", currentDir, ent->d_name);
-
-							addMenuItem(m, ent->d_name, fpath, 0);
-
-							free(fpath);
-						}
-					}
-				}
-			}
-		}
-	}
+	for (int i = m->page * ITEMS_PER_PAGE; i < dirListCount() && m->itemCount < ITEMS_PER_PAGE; i++)
+	{
+		char const* name = dirListName(i);
+		if (!name) break;
 
-	closedir(dir);
+		char* fpath = (char*)malloc(strlen(currentDir) + strlen(name) + 8);
+		sprintf(fpath, "%s/%s", currentDir, name);
 
-	m->nextPage = done;
+		addMenuItem(m, name, fpath, dirListIsDir(i));
+
+		free(fpath);
+	}
+
+	m->nextPage = (dirListBusy() || (m->page + 1) * ITEMS_PER_PAGE < dirListCount());
 
 	if (m->cursor >= m->itemCount)
 		m->cursor = m->itemCount - 1;
@@ -251,6 +262,27 @@ static void printItem(Menu* m)
 		clearScreen(&topScreen);
 	else
 		printRomInfo(m->items[m->cursor].value);
+
+	iprintf("\x1b[22;0HSort: %s - [Y]", sortNames[sortMode]);
+}
+
+void installPrompt(char* fpath)
+{
+	switch (subMenu())
+	{
+		case INSTALL_MENU_INSTALL:
+			install(fpath, false);
+			break;
+
+		case INSTALL_MENU_RANDOMIZE:
+			if (isDSiMode()) {
+				install(fpath, true);
+			}
+			break;
+
+		case INSTALL_MENU_BACK:					
+			break;
+	}
 }
 
 static int subMenu()
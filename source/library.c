@@ -0,0 +1,538 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <nds.h>
+
+#include "library.h"
+#include "main.h"
+#include "rom.h"
+#include "storage.h"
+
+#define LIBRARY_PATH APP_DATA_DIR "/library.bin"
+#define LIBRARY_MAGIC 0x494C464E	//"NFLI"
+#define LIBRARY_VERSION 1
+
+//where the scan starts, the SD card root unless the build says otherwise (the host bench does)
+#ifndef LIBRARY_ROOT
+#define LIBRARY_ROOT ""
+#endif
+
+#define NO_STRING 0xFFFFFFFF
+#define MAX_QUERY_WORDS 8
+#define MAX_WORD_LENGTH 64
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 entryCount;
+	u32 tokenCount;
+	u32 poolSize;
+} LibraryHeader;
+
+static LibraryEntry* entries = NULL;
+static u32 entryCount = 0;
+static u32 entryCap = 0;
+
+static LibraryToken* tokens = NULL;
+static u32 tokenCount = 0;
+static u32 tokenCap = 0;
+
+static char* pool = NULL;
+static u32 poolSize = 0;
+static u32 poolCap = 0;
+
+//range of the last search, typing more of the same word only looks inside it
+static u32 rangeStart = 0;
+static u32 rangeEnd = 0;
+static char rangeWord[MAX_WORD_LENGTH] = "";
+
+static LibraryProgress buildProgress = NULL;
+
+//folders on the SD card that never hold anything worth forwarding
+static const char* skipDirs[] = {
+	"/title",
+	"/sys",
+	"/_nds",
+	"/forwarders"
+};
+
+static bool _reserve(void** buf, u32* cap, u32 needed, u32 size)
+{
+	if (needed <= *cap)
+		return true;
+
+	u32 newCap = (*cap > 0) ? *cap : 256;
+	while (newCap < needed)
+		newCap *= 2;
+
+	void* p = realloc(*buf, newCap * size);
+	if (!p) return false;
+
+	*buf = p;
+	*cap = newCap;
+	return true;
+}
+
+static bool _isWordChar(char c)
+{
+	return isalnum((unsigned char)c) || (unsigned char)c >= 0x80;
+}
+
+static u32 _addString(char const* str, bool fold)
+{
+	u32 len = strlen(str) + 1;
+
+	if (!_reserve((void**)&pool, &poolCap, poolSize + len, sizeof(char)))
+		return NO_STRING;
+
+	u32 offset = poolSize;
+
+	for (u32 i = 0; i < len; i++)
+		pool[offset + i] = fold ? tolower((unsigned char)str[i]) : str[i];
+
+	poolSize += len;
+	return offset;
+}
+
+static bool _addEntry(char const* path, char const* name, sNDSBannerExt* banner)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f) return true;
+
+	char title[128+1] = "";
+	char code[4+1] = "";
+
+	tNDSHeader h;
+	if (fread(&h, sizeof(tNDSHeader), 1, f) == 1)
+	{
+		sprintf(code, "%.4s", h.gameCode);
+
+		//the first three banner versions hold every title getGameTitle() can pick
+		memset(banner, 0, sizeof(sNDSBannerExt));
+		if (h.bannerOffset != 0 &&
+			fseek(f, h.bannerOffset, SEEK_SET) == 0 &&
+			fread(banner, NDS_BANNER_SIZE_ZH_KO, 1, f) == 1)
+		{
+			getGameTitle(banner, title, false);
+		}
+	}
+
+	fclose(f);
+
+	if (!_reserve((void**)&entries, &entryCap, entryCount + 1, sizeof(LibraryEntry)))
+		return false;
+
+	LibraryEntry* e = &entries[entryCount];
+	e->path = _addString(path, false);
+	e->name = _addString(name, true);
+	e->title = _addString(title, true);
+	e->code = _addString(code, true);
+
+	if (e->path == NO_STRING || e->name == NO_STRING || e->title == NO_STRING || e->code == NO_STRING)
+		return false;
+
+	entryCount += 1;
+
+	if (buildProgress && entryCount % 16 == 0)
+		buildProgress(entryCount);
+
+	return true;
+}
+
+static bool _scanDir(char* path, sNDSBannerExt* banner)
+{
+	DIR* dir = opendir(path[0] == '\0' ? "/" : path);
+	if (!dir) return true;
+
+	bool result = true;
+	int len = strlen(path);
+	struct dirent* ent;
+
+	while (result && (ent = readdir(dir)))
+	{
+		//skips . and .. as well as hidden folders
+		if (ent->d_name[0] == '.')
+			continue;
+
+		if (len + strlen(ent->d_name) + 2 > 512)
+			continue;
+
+		sprintf(path + len, "/%s", ent->d_name);
+
+		if (ent->d_type == DT_DIR)
+		{
+			bool skip = false;
+
+			for (int i = 0; i < sizeof(skipDirs) / sizeof(skipDirs[0]); i++)
+			{
+				if (strcasecmp(path + strlen(LIBRARY_ROOT), skipDirs[i]) == 0)
+					skip = true;
+			}
+
+			if (!skip)
+				result = _scanDir(path, banner);
+		}
+
+		else if (isRomFile(ent->d_name))
+			result = _addEntry(path, ent->d_name, banner);
+
+		path[len] = '\0';
+	}
+
+	closedir(dir);
+	return result;
+}
+
+static bool _addTokens(u32 entry, u32 str)
+{
+	for (u32 i = str; pool[i] != '\0'; i++)
+	{
+		if (!_isWordChar(pool[i]))
+			continue;
+
+		if (i > str && _isWordChar(pool[i-1]))
+			continue;
+
+		if (!_reserve((void**)&tokens, &tokenCap, tokenCount + 1, sizeof(LibraryToken)))
+			return false;
+
+		tokens[tokenCount].key = i;
+		tokens[tokenCount].entry = entry;
+		tokenCount += 1;
+	}
+
+	return true;
+}
+
+//orders two words, a word ends at the first character that isn't part of one
+static int _compareWords(char const* a, char const* b)
+{
+	while (_isWordChar(*a) && _isWordChar(*b) && *a == *b)
+	{
+		a++;
+		b++;
+	}
+
+	int ca = _isWordChar(*a) ? (unsigned char)*a : 0;
+	int cb = _isWordChar(*b) ? (unsigned char)*b : 0;
+
+	return ca - cb;
+}
+
+//0 if word starts with prefix, otherwise the order of word against it
+static int _comparePrefix(char const* word, char const* prefix)
+{
+	for (; *prefix != '\0'; word++, prefix++)
+	{
+		int c = _isWordChar(*word) ? (unsigned char)*word : 0;
+
+		if (c != (unsigned char)*prefix)
+			return c - (unsigned char)*prefix;
+	}
+
+	return 0;
+}
+
+static int _compareTokens(const void* a, const void* b)
+{
+	const LibraryToken* ta = (const LibraryToken*)a;
+	const LibraryToken* tb = (const LibraryToken*)b;
+
+	int result = _compareWords(pool + ta->key, pool + tb->key);
+	if (result != 0)
+		return result;
+
+	//keep entries in scan order within a word
+	return (ta->entry > tb->entry) - (ta->entry < tb->entry);
+}
+
+static bool _hasWordPrefix(char const* str, char const* prefix)
+{
+	for (int i = 0; str[i] != '\0'; i++)
+	{
+		if (!_isWordChar(str[i]) || (i > 0 && _isWordChar(str[i-1])))
+			continue;
+
+		if (_comparePrefix(str + i, prefix) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+bool libraryLoad()
+{
+	libraryFree();
+
+	FILE* f = fopen(LIBRARY_PATH, "rb");
+	if (!f) return false;
+
+	bool result = false;
+	LibraryHeader h;
+
+	if (fread(&h, sizeof(h), 1, f) == 1 &&
+		h.magic == LIBRARY_MAGIC &&
+		h.version == LIBRARY_VERSION &&
+		h.poolSize > 0)
+	{
+		entries = (LibraryEntry*)malloc(h.entryCount * sizeof(LibraryEntry) + 1);
+		tokens = (LibraryToken*)malloc(h.tokenCount * sizeof(LibraryToken) + 1);
+		pool = (char*)malloc(h.poolSize);
+
+		if (entries && tokens && pool &&
+			fread(entries, sizeof(LibraryEntry), h.entryCount, f) == h.entryCount &&
+			fread(tokens, sizeof(LibraryToken), h.tokenCount, f) == h.tokenCount &&
+			fread(pool, 1, h.poolSize, f) == h.poolSize)
+		{
+			entryCount = entryCap = h.entryCount;
+			tokenCount = tokenCap = h.tokenCount;
+			poolSize = poolCap = h.poolSize;
+			result = (pool[poolSize-1] == '\0');
+
+			//never trust an offset from the card
+			for (u32 i = 0; i < entryCount && result; i++)
+			{
+				if (entries[i].path >= poolSize || entries[i].name >= poolSize ||
+					entries[i].title >= poolSize || entries[i].code >= poolSize)
+					result = false;
+			}
+
+			for (u32 i = 0; i < tokenCount && result; i++)
+			{
+				if (tokens[i].key >= poolSize || tokens[i].entry >= entryCount)
+					result = false;
+			}
+		}
+	}
+
+	fclose(f);
+
+	if (!result)
+		libraryFree();
+
+	return result;
+}
+
+bool librarySave()
+{
+	mkdir(APP_DATA_ROOT, 0777);
+	mkdir(APP_DATA_DIR, 0777);
+
+	unsigned long long oldSize = getFileSizePath(LIBRARY_PATH);
+
+	FILE* f = fopen(LIBRARY_PATH, "wb");
+	if (!f) return false;
+
+	LibraryHeader h = {
+		LIBRARY_MAGIC,
+		LIBRARY_VERSION,
+		entryCount,
+		tokenCount,
+		poolSize
+	};
+
+	bool result = (fwrite(&h, sizeof(h), 1, f) == 1 &&
+				   fwrite(entries, sizeof(LibraryEntry), entryCount, f) == entryCount &&
+				   fwrite(tokens, sizeof(LibraryToken), tokenCount, f) == tokenCount &&
+				   fwrite(pool, 1, poolSize, f) == poolSize);
+
+	fclose(f);
+
+	if (!result)
+		remove(LIBRARY_PATH);
+
+	sdLedgerResize(oldSize, result ? getFileSizePath(LIBRARY_PATH) : 0);
+	return result;
+}
+
+int libraryBuild(LibraryProgress progress)
+{
+	libraryFree();
+	buildProgress = progress;
+
+	//keep the empty string at offset 0 so the pool is never empty
+	_addString("", false);
+
+	sNDSBannerExt* banner = (sNDSBannerExt*)malloc(sizeof(sNDSBannerExt));
+	if (!banner) return -1;
+
+	char path[512] = LIBRARY_ROOT;
+	bool result = _scanDir(path, banner);
+	free(banner);
+
+	for (u32 i = 0; i < entryCount && result; i++)
+	{
+		result = _addTokens(i, entries[i].name) &&
+				 _addTokens(i, entries[i].title) &&
+				 _addTokens(i, entries[i].code);
+	}
+
+	if (!result)
+	{
+		libraryFree();
+		return -1;
+	}
+
+	qsort(tokens, tokenCount, sizeof(LibraryToken), _compareTokens);
+
+	return entryCount;
+}
+
+void libraryFree()
+{
+	free(entries);
+	free(tokens);
+	free(pool);
+
+	entries = NULL;
+	tokens = NULL;
+	pool = NULL;
+
+	entryCount = entryCap = 0;
+	tokenCount = tokenCap = 0;
+	poolSize = poolCap = 0;
+
+	rangeWord[0] = '\0';
+}
+
+int libraryCount()
+{
+	return entryCount;
+}
+
+char const* libraryPath(int entry)
+{
+	if (entry < 0 || entry >= entryCount)
+		return NULL;
+
+	return pool + entries[entry].path;
+}
+
+int librarySearch(char const* query, int* results, int max)
+{
+	if (!query || !results || entryCount == 0)
+		return 0;
+
+	//fold and split the query into words
+	char words[MAX_QUERY_WORDS][MAX_WORD_LENGTH];
+	int wordCount = 0;
+
+	for (char const* c = query; *c != '\0' && wordCount < MAX_QUERY_WORDS; )
+	{
+		if (!_isWordChar(*c))
+		{
+			c++;
+			continue;
+		}
+
+		int len = 0;
+		for (; _isWordChar(*c); c++)
+		{
+			if (len < MAX_WORD_LENGTH - 1)
+				words[wordCount][len++] = tolower((unsigned char)*c);
+		}
+
+		words[wordCount++][len] = '\0';
+	}
+
+	if (wordCount == 0)
+	{
+		rangeWord[0] = '\0';
+		return 0;
+	}
+
+	//the first word picks a range of the sorted tokens
+	u32 lo = 0;
+	u32 hi = tokenCount;
+
+	if (rangeWord[0] != '\0' && strncmp(words[0], rangeWord, strlen(rangeWord)) == 0)
+	{
+		lo = rangeStart;
+		hi = rangeEnd;
+	}
+
+	u32 first = lo;
+	u32 last = hi;
+
+	while (first < last)
+	{
+		u32 mid = first + (last - first) / 2;
+
+		if (_comparePrefix(pool + tokens[mid].key, words[0]) < 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	lo = first;
+	last = hi;
+
+	while (first < last)
+	{
+		u32 mid = first + (last - first) / 2;
+
+		if (_comparePrefix(pool + tokens[mid].key, words[0]) <= 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	hi = first;
+
+	rangeStart = lo;
+	rangeEnd = hi;
+	sprintf(rangeWord, "%s", words[0]);
+
+	//an entry can match through several of its words, only list it once
+	u8* seen = (u8*)calloc((entryCount + 7) / 8, 1);
+	if (!seen) return 0;
+
+	int count = 0;
+
+	for (u32 i = lo; i < hi && count < max; i++)
+	{
+		u32 e = tokens[i].entry;
+
+		if (seen[e / 8] & BIT(e % 8))
+			continue;
+
+		seen[e / 8] |= BIT(e % 8);
+
+		//every other word has to start a word somewhere in the entry
+		bool match = true;
+
+		for (int w = 1; w < wordCount && match; w++)
+		{
+			match = _hasWordPrefix(pool + entries[e].name, words[w]) ||
+					_hasWordPrefix(pool + entries[e].title, words[w]) ||
+					_hasWordPrefix(pool + entries[e].code, words[w]);
+		}
+
+		if (match)
+			results[count++] = e;
+	}
+
+	free(seen);
+	return count;
+}
@@ -18,7 +18,9 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <sys/stat.h>
 
 #include <nds.h>
 #include <fat.h>
@@ -27,14 +29,30 @@
 #include "menu.h"
 #include "message.h"
 #include "nitrofs.h"
+#include "storage.h"
 
 #define VERSION "0.3.1"
 
+//most nitro data nitroFSInit() will load into RAM
+#define NITRO_RESIDENT_MAX (1024 * 1024)
+
+//which image nitroFSInit() found last time, "*" for the default nitroFSInit(NULL)
+#define NITRO_PATH_FILE APP_DATA_DIR "/nitropath.txt"
+
+//time each idle main menu frame may spend on storage stats, in cpuGetTiming() ticks
+#define STATS_STEP_TICKS (BUS_CLOCK / 100)
+
 PrintConsole topScreen;
 PrintConsole bottomScreen;
 
+u32 startupTicks[STARTUP_COUNT] = { 0 };
+
+static char const* appPath = NULL;
+static bool nitroMounted = false;
+
 enum {
 	MAIN_MENU_INSTALL,
+	MAIN_MENU_SEARCH,
 	MAIN_MENU_TEST,
 	MAIN_MENU_EXIT
 };
@@ -74,6 +92,7 @@ static int _mainMenu(int cursor)
 	setMenuHeader(m, "MAIN MENU");
 
 	addMenuItem(m, "Install", NULL, 0);
+	addMenuItem(m, "Search", NULL, 0);
 	addMenuItem(m, "Test", NULL, 0);
 	addMenuItem(m, "Shut Down", NULL, 0);
 
@@ -82,9 +101,20 @@ static int _mainMenu(int cursor)
 	//bottom screen
 	printMenu(m);
 
+	//the first draw ends the startup timeline
+	if (startupTicks[STARTUP_MENU] == 0)
+	{
+		startupTicks[STARTUP_MENU] = cpuGetTiming();
+		cpuEndTiming();
+	}
+
 	while (1)
 	{
 		swiWaitForVBlank();
+
+		//the test menu's storage numbers are worked out while this menu sits idle
+		storageStatsStep(STATS_STEP_TICKS);
+
 		scanKeys();
 
 		if (moveCursor(m))
@@ -109,10 +139,81 @@ static int _mainMenu(int cursor)
 	return false;
 } */
 
+//NitroFS is only needed for the templates, so it's mounted the first time they are
+bool mountNitroFS()
+{
+	if (nitroMounted) return true;
+
+	cpuStartTiming(2);
+
+	char last[256] = "";
+	FILE* f = fopen(NITRO_PATH_FILE, "r");
+
+	if (f)
+	{
+		if (!fgets(last, sizeof(last), f))
+			last[0] = '\0';
+
+		last[strcspn(last, "\r\n")] = '\0';
+		fclose(f);
+	}
+
+	//whatever worked last time goes first
+	char const* probes[] = { last, "*", appPath, "/NDSForwarder.dsi", "/NDSForwarder.nds" };
+
+	nitroFSSetResident(isDSiMode() ? NITRO_RESIDENT_MAX : 0);
+
+	for (int i = 0; i < (int)(sizeof(probes) / sizeof(probes[0])); i++)
+	{
+		char const* probe = probes[i];
+
+		if (!probe || probe[0] == '\0') continue;
+		if (i > 0 && strcmp(probe, last) == 0) continue;
+
+		if (nitroFSInit(strcmp(probe, "*") == 0 ? NULL : probe))
+		{
+			nitroMounted = true;
+
+			if (strcmp(probe, last) != 0)
+			{
+				mkdir(APP_DATA_ROOT, 0777);
+				mkdir(APP_DATA_DIR, 0777);
+
+				unsigned long long oldSize = getFileSizePath(NITRO_PATH_FILE);
+
+				f = fopen(NITRO_PATH_FILE, "w");
+				if (f)
+				{
+					fprintf(f, "%s\n", probe);
+					fclose(f);
+					sdLedgerResize(oldSize, strlen(probe) + 1);
+				}
+			}
+
+			break;
+		}
+	}
+
+	startupTicks[STARTUP_NITRO] = cpuEndTiming();
+
+	if (!nitroMounted)
+		messageBox("nitroFSInit()...\x1B[31mFailed\n\x1B[47m");
+
+	return nitroMounted;
+}
+
 int main(int argc, char **argv)
 {
+	//startup timeline until the first menu draw. libnds times with one shared timer whatever
+	//number is passed, so nothing else may start timing before then
+	cpuStartTiming(2);
+
 	srand(time(0));
 	_setupScreens();
+	startupTicks[STARTUP_SCREENS] = cpuGetTiming();
+
+	//held d-pad repeats after 20 frames, then every 4
+	keysSetRepeat(20, 4);
 
 	//DSi check (No longer needed)
 	/* if (!isDSiMode() || !isRetailDSi())
@@ -128,11 +229,10 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
-	// setup NitroFS
-	if(!nitroFSInit(NULL)) if(!nitroFSInit(argv[0])) if(!nitroFSInit("/NDSForwarder.dsi")) if(!nitroFSInit("/NDSForwarder.nds")) {
-		messageBox("nitroFSInit()...\x1B[31mFailed\n\x1B[47m");
-		return 0;
-	}
+	startupTicks[STARTUP_FAT] = cpuGetTiming();
+
+	//NitroFS waits for mountNitroFS(), the templates are small enough to keep in RAM on DSi
+	appPath = (argc > 0) ? argv[0] : NULL;
 
 	//main menu
 	bool programEnd = false;
@@ -148,6 +248,10 @@ int main(int argc, char **argv)
 				installMenu();
 				break;
 
+			case MAIN_MENU_SEARCH:
+				searchMenu();
+				break;
+
 			case MAIN_MENU_TEST:
 				testMenu();
 				break;
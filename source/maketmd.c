@@ -37,42 +37,58 @@ distribution.
 #include <string.h>
 #include <stdlib.h>
 #include <machine/endian.h>
+#include <sys/stat.h>
 
 #include <nds.h>
 
 #include "main.h"
+#include "maketmd.h"
 #include "storage.h"
 
 //#define TMD_CREATOR_VER  "0.2"
 
-#define TMD_SIZE		  0x208
-#define SHA_BUFFER_SIZE	  0x200
-#define SHA_DIGEST_LENGTH 0x14
+#define SHA_BUFFER_SIZE	  sizeof(tDSiHeader)	//the first read holds the whole header
+#define SHA_DIGEST_LENGTH SHA1_DIGEST_LENGTH
 
-void tmd_create(uint8_t* tmd, FILE* app)
+#define TMD_CACHE_MAGIC 0x43544E46	//"FNTC"
+#define TMD_CACHE_VERSION 1
+#define TMD_CACHE_MAX 64	//most recently used first, the oldest fall off
+
+typedef struct {
+	u32 magic;
+	u32 version;
+	u32 count;
+} TmdCacheHeader;
+
+typedef struct {
+	TmdKey key;
+	u32 size;
+	u8 sha1[SHA_DIGEST_LENGTH];
+} TmdCacheEntry;
+
+#define VERIFY_BUFFER_SIZE 0x10000	//verifying has no progress bar to feed, so read in big pieces
+
+// Phases 1 to 6 only need the header, so they are done before any of the app is hashed
+void tmdInit(TmdBuilder* b, tDSiHeader const* header)
 {
+	uint8_t* tmd = b->tmd;
+	memset(tmd, 0, TMD_SIZE);
+
 	// Phase 1 - offset 0x18C (Title ID, first part)
 	{
-		fseek(app, 0x234, SEEK_SET);
-
-		uint32_t value;
-		fread(&value, 4, 1, app);
-		value = __bswap32(value);
-
+		uint32_t value = __bswap32(header->tid_high);
 		memcpy(tmd + 0x18c, &value, 4);
 	}
 
 	// Phase 2 - offset 0x190 (Title ID, second part)
 	{
 		// We can take this also from 0x230, but reversed
-		fseek(app, 0x0C, SEEK_SET);
-		fread((char*)&tmd[0x190], 4, 1, app);
+		memcpy(tmd + 0x190, header->ndshdr.gameCode, 4);
 	}
 
 	// Phase 3 - offset 0x198 (Group ID = '01')
 	{
-		fseek(app, 0x10, SEEK_SET);
-		fread((char*)&tmd[0x198], 2, 1, app);
+		memcpy(tmd + 0x198, header->ndshdr.makercode, 2);
 	}
 
 	// Phase 4 - offset 0x1AA (fill-in 0x80 value, 0x10 times)
@@ -94,50 +110,155 @@ void tmd_create(uint8_t* tmd, FILE* app)
 		tmd[0x1EB] = 0x01;
 	}
 
+	b->size = 0;
+	sha1Init(&b->sha1);
+}
+
+// Feeds the next piece of the app, from the start and in order
+void tmdUpdate(TmdBuilder* b, void const* data, uint32_t len)
+{
+	sha1Update(&b->sha1, data, len);
+	b->size += len;
+}
+
+// Fills in the size and hash of everything fed, and copies out the TMD_SIZE bytes
+void tmdFinal(TmdBuilder* b, uint8_t* tmd)
+{
 	// Phase 7 - offset, 0x1EC (file size, 8B)
-	uint32_t filesize = 0;
-	uint32_t fileread = 0;
 	{
-		fseek(app, 0, SEEK_END);
-		filesize = ftell(app);
-		uint32_t size = __bswap32(filesize);
+		uint32_t size = __bswap32(b->size);
 
 		// We only use 4B for size as for now
-		memcpy((tmd + 0x1F0), &size, sizeof(u32));
+		memcpy((b->tmd + 0x1F0), &size, sizeof(u32));
 	}
 
 	// Phase 8 - offset, 0x1F4 (SHA1 sum, 20B)
 	{
-		// Makes use of libnds
-		fseek(app, 0, SEEK_SET);
+		// Makes use of sha1.c, which can still hand off to the BIOS
+		sha1Final(b->tmd + 0x1F4, &b->sha1);
+	}
 
-		uint8_t buffer[SHA_BUFFER_SIZE] = { 0 };
-		uint32_t buffer_read = 0;
+	memcpy(tmd, b->tmd, TMD_SIZE);
+}
 
-		swiSHA1context_t ctx;
-		swiSHA1Init(&ctx);
+// Builds the TMD in one pass over app, the header comes from the first read. 0 if it did
+int tmd_create(uint8_t* tmd, FILE* app)
+{
+	struct stat st;
+	uint32_t filesize = (fstat(fileno(app), &st) == 0) ? st.st_size : 0;
+	uint32_t fileread = 0;
 
-		do {
-			buffer_read = fread((char*)&buffer[0], 1, SHA_BUFFER_SIZE, app);
-			fileread += buffer_read;
+	uint8_t* buffer = (uint8_t*)calloc(1, SHA_BUFFER_SIZE);
 
-			swiSHA1Update(&ctx, buffer, buffer_read);
+	if (!buffer)
+		return 1;
 
-			printProgressBar((float)fileread / (float)filesize);
-		}
-		while(buffer_read == SHA_BUFFER_SIZE);
+	uint32_t buffer_read = fread((char*)&buffer[0], 1, SHA_BUFFER_SIZE, app);
+
+	TmdBuilder builder;
+	tmdInit(&builder, (tDSiHeader const*)buffer);
 
-		clearProgressBar();
-		consoleSelect(&bottomScreen);
+	while (buffer_read > 0)
+	{
+		tmdUpdate(&builder, buffer, buffer_read);
+		fileread += buffer_read;
 
-		swiSHA1Final(buffer, &ctx);
+		if (filesize > 0)
+			printProgressBar((float)fileread / (float)filesize);
 
-		//Store SHA1 sum
-		memcpy((tmd + 0x1F4), buffer, SHA_DIGEST_LENGTH);
+		if (buffer_read != SHA_BUFFER_SIZE)
+			break;
+
+		buffer_read = fread((char*)&buffer[0], 1, SHA_BUFFER_SIZE, app);
 	}
+
+	clearProgressBar();
+	consoleSelect(&bottomScreen);
+
+	tmdFinal(&builder, tmd);
+	free(buffer);
+	return 0;
+}
+
+// FNV-1a, only has to tell game paths apart
+u32 tmdPathHash(void const* data, u32 len)
+{
+	u8 const* p = (u8 const*)data;
+	u32 hash = 0x811C9DC5;
+
+	for (u32 i = 0; i < len; i++)
+		hash = (hash ^ p[i]) * 0x01000193;
+
+	return hash;
+}
+
+// Reads the whole cache, returns the number of entries or 0 if there is none
+static int _tmdCacheLoad(TmdCacheEntry* cache)
+{
+	FILE* f = fopen(TMD_CACHE_PATH, "rb");
+	if (!f) return 0;
+
+	int count = 0;
+	TmdCacheHeader h;
+
+	if (fread(&h, sizeof(h), 1, f) == 1 &&
+		h.magic == TMD_CACHE_MAGIC &&
+		h.version == TMD_CACHE_VERSION &&
+		h.count <= TMD_CACHE_MAX &&
+		fread(cache, sizeof(TmdCacheEntry), h.count, f) == h.count)
+		count = h.count;
+
+	fclose(f);
+	return count;
+}
+
+static void _tmdCacheSave(TmdCacheEntry const* cache, int count)
+{
+	mkdir(APP_DATA_ROOT, 0777);
+	mkdir(APP_DATA_DIR, 0777);
+
+	unsigned long long oldSize = getFileSizePath(TMD_CACHE_PATH);
+
+	FILE* f = fopen(TMD_CACHE_PATH, "wb");
+	if (!f) return;
+
+	TmdCacheHeader h = {
+		TMD_CACHE_MAGIC,
+		TMD_CACHE_VERSION,
+		count
+	};
+
+	bool result = (fwrite(&h, sizeof(h), 1, f) == 1 &&
+				   fwrite(cache, sizeof(TmdCacheEntry), count, f) == count);
+
+	fclose(f);
+
+	if (!result)
+		remove(TMD_CACHE_PATH);
+
+	sdLedgerResize(oldSize, result ? getFileSizePath(TMD_CACHE_PATH) : 0);
+}
+
+// Closes both files, drops the unfinished TMD and says why
+static int _tmdAbort(FILE* app, FILE* tmd, char const* tmdPath, char const* error)
+{
+	fclose(app);
+	fclose(tmd);
+	remove(tmdPath);
+
+	iprintf("\x1B[31m");	//red
+	iprintf("%s", error);
+	iprintf("\x1B[47m");	//white
+	return 1;
 }
 
 int maketmd(char* input, char* tmdPath)
+{
+	return maketmdCached(input, tmdPath, NULL);
+}
+
+// With a key, a cached size and SHA1 sum stand in for hashing the app when its size still agrees
+int maketmdCached(char* input, char* tmdPath, TmdKey const* key)
 {
 	iprintf("MakeTMD for DSiWare Homebrew\n");
 	iprintf("by Przemyslaw Skryjomski\n\t(Tuxality)\n");
@@ -172,12 +293,101 @@ int maketmd(char* input, char* tmdPath)
 	}
 
 	// Allocate memory for TMD
-	uint8_t* tmd_template = (uint8_t*)malloc(sizeof(uint8_t) * TMD_SIZE);
-	memset(tmd_template, 0, sizeof(uint8_t) * TMD_SIZE); // zeroed
+	uint8_t* tmd_template = (uint8_t*)calloc(1, sizeof(uint8_t) * TMD_SIZE); // zeroed
+
+	if (!tmd_template)
+		return _tmdAbort(app, tmd, tmdPath, "Not enough memory to build the TMD.\n");
+
+	TmdCacheEntry* cache = NULL;
+	int count = 0;
+	int hit = -1;
+
+	if (key)
+	{
+		cache = (TmdCacheEntry*)malloc(sizeof(TmdCacheEntry) * TMD_CACHE_MAX);
+		if (cache) count = _tmdCacheLoad(cache);
+
+		struct stat st;
+		uint32_t filesize = (fstat(fileno(app), &st) == 0) ? st.st_size : 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			if (memcmp(&cache[i].key, key, sizeof(TmdKey)) == 0 && cache[i].size == filesize)
+			{
+				hit = i;
+				break;
+			}
+		}
+	}
 
 	// Prepare TMD template then write to file
-	tmd_create(tmd_template, app);
-	fwrite((const char*)(&tmd_template[0]), TMD_SIZE, 1, tmd);
+	if (hit >= 0)
+	{
+		// Only the header is read, the size and hash come from the cache
+		tDSiHeader* header = (tDSiHeader*)calloc(1, sizeof(tDSiHeader));
+
+		if (!header)
+		{
+			free(cache);
+			free(tmd_template);
+			return _tmdAbort(app, tmd, tmdPath, "Not enough memory to build the TMD.\n");
+		}
+
+		if (fread(header, 1, sizeof(tDSiHeader), app) != sizeof(tDSiHeader))
+		{
+			free(header);
+			free(cache);
+			free(tmd_template);
+			return _tmdAbort(app, tmd, tmdPath, "Failed to read the app header.\n");
+		}
+
+		TmdBuilder builder;
+		tmdInit(&builder, header);
+		memcpy(tmd_template, builder.tmd, TMD_SIZE);
+		free(header);
+
+		uint32_t size = __bswap32(cache[hit].size);
+		memcpy(tmd_template + 0x1F0, &size, sizeof(u32));
+		memcpy(tmd_template + 0x1F4, cache[hit].sha1, SHA_DIGEST_LENGTH);
+	}
+	else if (tmd_create(tmd_template, app) != 0)
+	{
+		free(cache);
+		free(tmd_template);
+		return _tmdAbort(app, tmd, tmdPath, "Not enough memory to build the TMD.\n");
+	}
+
+	// A write error may only show once the buffer is flushed
+	if (fwrite((const char*)(&tmd_template[0]), TMD_SIZE, 1, tmd) != 1 || fflush(tmd) != 0)
+	{
+		free(cache);
+		free(tmd_template);
+		return _tmdAbort(app, tmd, tmdPath, "Failed to write the TMD.\n");
+	}
+
+	// Move the entry to the front, a new one pushes the oldest out
+	if (cache)
+	{
+		TmdCacheEntry entry;
+
+		if (hit >= 0)
+		{
+			entry = cache[hit];
+		}
+		else
+		{
+			memcpy(&entry.key, key, sizeof(TmdKey));
+			entry.size = __bswap32(*(uint32_t*)(tmd_template + 0x1F0));
+			memcpy(entry.sha1, tmd_template + 0x1F4, SHA_DIGEST_LENGTH);
+			hit = (count < TMD_CACHE_MAX) ? count++ : count - 1;
+		}
+
+		memmove(cache + 1, cache, sizeof(TmdCacheEntry) * hit);
+		cache[0] = entry;
+
+		_tmdCacheSave(cache, count);
+		free(cache);
+	}
 
 	// Free allocated memory for TMD
 	free(tmd_template);
@@ -187,4 +397,87 @@ int maketmd(char* input, char* tmdPath)
 	fclose(tmd);
 
 	return 0;
-}
\ No newline at end of file
+}
+
+// Rehashes the app a TMD in contentPath names and compares the size and SHA1 sum (0x1F0 - 0x208)
+// Only unsigned TMDs, as made by maketmd, are rewritten; a signed one would lose its signature
+int tmdVerify(char const* contentPath, bool repair)
+{
+	char path[512];
+	uint8_t old[TMD_SIZE];
+	bool haveOld = false;
+
+	snprintf(path, sizeof(path), "%s/title.tmd", contentPath);
+	FILE* f = fopen(path, "rb");
+
+	if (f)
+	{
+		haveOld = (fread(old, 1, TMD_SIZE, f) == TMD_SIZE);
+		fclose(f);
+	}
+
+	// Content ID at 0x1E4 names the app, homebrew always has 00000000
+	uint32_t contentId = 0;
+
+	if (haveOld)
+	{
+		memcpy(&contentId, old + 0x1E4, 4);
+		contentId = __bswap32(contentId);
+	}
+
+	snprintf(path, sizeof(path), "%s/%08lx.app", contentPath, (unsigned long)contentId);
+	FILE* app = fopen(path, "rb");
+
+	if (!app)
+		return TMD_VERIFY_ERROR;
+
+	uint8_t* buffer = (uint8_t*)malloc(VERIFY_BUFFER_SIZE);
+
+	if (!buffer)
+	{
+		fclose(app);
+		return TMD_VERIFY_ERROR;
+	}
+
+	uint32_t buffer_read = fread(buffer, 1, VERIFY_BUFFER_SIZE, app);
+
+	if (buffer_read < sizeof(tDSiHeader))
+	{
+		free(buffer);
+		fclose(app);
+		return TMD_VERIFY_ERROR;
+	}
+
+	TmdBuilder builder;
+	tmdInit(&builder, (tDSiHeader const*)buffer);
+
+	while (buffer_read > 0)
+	{
+		tmdUpdate(&builder, buffer, buffer_read);
+		buffer_read = fread(buffer, 1, VERIFY_BUFFER_SIZE, app);
+	}
+
+	free(buffer);
+	fclose(app);
+
+	uint8_t tmd[TMD_SIZE];
+	tmdFinal(&builder, tmd);
+
+	if (haveOld && memcmp(old + 0x1F0, tmd + 0x1F0, TMD_SIZE - 0x1F0) == 0)
+		return TMD_VERIFY_OK;
+
+	// Signature type at 0, left zero by maketmd
+	if (!repair || (haveOld && (old[0] | old[1] | old[2] | old[3]) != 0))
+		return TMD_VERIFY_MISMATCH;
+
+	snprintf(path, sizeof(path), "%s/title.tmd", contentPath);
+	f = fopen(path, "wb");
+
+	if (!f)
+		return TMD_VERIFY_MISMATCH;
+
+	bool written = (fwrite(tmd, 1, TMD_SIZE, f) == TMD_SIZE);
+	fclose(f);
+
+	return written ? TMD_VERIFY_REPAIRED : TMD_VERIFY_MISMATCH;
+}
@@ -31,6 +31,7 @@ Menu* newMenu()
 	m->cursor = 0;
 	m->page = 0;
 	m->itemCount = 0;
+	m->itemTotal = 0;
 	m->nextPage = false;
 	m->changePage = 0;
 	m->header[0] = '\0';
@@ -167,9 +168,13 @@ void printMenu(Menu* m)
 
 	if (m->nextPage)
 		iprintf("\x1b[21;31Hv");
+
+	//page indicator, once the length of the list is known
+	if (m->itemTotal > ITEMS_PER_PAGE)
+		iprintf("\x1b[23;0HPage %d of %d", m->page + 1, (m->itemTotal + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE);
 }
 
-static void _moveCursor(Menu* m, int dir)
+static void _stepCursor(Menu* m, int dir)
 {
 	if (m->changePage != 0)
 		return;
@@ -201,6 +206,47 @@ static void _moveCursor(Menu* m, int dir)
 	}		
 }
 
+static void _moveCursor(Menu* m, int dir)
+{
+	//total unknown, walk one item at a time and stop at a page boundary
+	if (m->itemTotal <= 0)
+	{
+		repeat(abs(dir))
+			_stepCursor(m, dir);
+
+		return;
+	}
+
+	//total known, move anywhere in the list at once
+	int index = m->page * ITEMS_PER_PAGE + m->cursor + dir;
+
+	if (index < 0)
+		index = 0;
+
+	if (index > m->itemTotal-1)
+		index = m->itemTotal-1;
+
+	m->changePage = (index / ITEMS_PER_PAGE) - m->page;
+	m->cursor = index % ITEMS_PER_PAGE;
+}
+
+//number of frames a direction has been held, drives the repeat acceleration
+static int heldFrames = 0;
+
+static int _acceleration()
+{
+	if (heldFrames < 60)
+		return 1;
+
+	else if (heldFrames < 120)
+		return 2;
+
+	else if (heldFrames < 180)
+		return 4;
+
+	return 8;
+}
+
 bool moveCursor(Menu* m)
 {
 	if (!m) return false;
@@ -208,23 +254,40 @@ bool moveCursor(Menu* m)
 	m->changePage = 0;
 	int lastCursor = m->cursor;
 
-	if (keysDown() & KEY_DOWN)
-		_moveCursor(m, 1);
+	if (keysHeld() & (KEY_UP | KEY_DOWN | KEY_LEFT | KEY_RIGHT))
+		heldFrames += 1;
+	else
+		heldFrames = 0;
 
-	else if (keysDown() & KEY_UP)
-		_moveCursor(m, -1);
+	//keysDownRepeat() also fires on the initial press, and clears itself when read
+	u32 keys = keysDownRepeat();
+	int step = _acceleration();
 
-	if (keysDown() & KEY_RIGHT)
-	{
-		repeat(10)
-			_moveCursor(m, 1);
-	}
+	if (keys & KEY_DOWN)
+		_moveCursor(m, step);
 
-	else if (keysDown() & KEY_LEFT)
-	{
-		repeat(10)
-			_moveCursor(m, -1);
-	}
+	else if (keys & KEY_UP)
+		_moveCursor(m, -step);
+
+	if (keys & KEY_RIGHT)
+		_moveCursor(m, 10 * step);
+
+	else if (keys & KEY_LEFT)
+		_moveCursor(m, -10 * step);
+
+	return !(lastCursor == m->cursor && m->changePage == 0);
+}
+
+bool jumpCursor(Menu* m, int index)
+{
+	if (!m) return false;
+	if (index < 0) return false;
+	if (m->itemTotal > 0 && index >= m->itemTotal) return false;
+
+	int lastCursor = m->cursor;
+
+	m->changePage = (index / ITEMS_PER_PAGE) - m->page;
+	m->cursor = index % ITEMS_PER_PAGE;
 
-	return !(lastCursor == m->cursor);
+	return !(lastCursor == m->cursor && m->changePage == 0);
 }
\ No newline at end of file
@@ -42,6 +42,30 @@
 		* Updated GBA SLOT detection to check for game code and header CRC.
 	2020-08-24 v0.11 - SDNAND support (by RocketRobz)
 		* Added support for being mounted from SDNAND, if app is launched by hiyaCFW.
+	2026-10-18 v0.12 - in-RAM directory index
+		* FNT and FAT are loaded once by nitroFSInit(), names are looked up through a hash of
+		  (parent dir, name) so open, stat, chdir and diropen no longer touch the file.
+	2026-10-18 v0.13 - block cache
+		* Reads from the .nds file go through a small LRU cache of sector aligned blocks, size
+		  and count set with nitroFSSetCache(), hit rate from nitroFSGetCacheStats().
+	2026-10-18 v0.14 - mount context
+		* The globals moved into struct nitroMount, handles point at their mount and read with
+		  nitroPread() at their own position through a small per-handle buffer.
+	2026-10-18 v0.15 - export
+		* nitroFSExport() copies a file's byte range from the image straight into a FILE.
+	2026-10-18 v0.16 - compressed files
+		* name.lz files holding LZ77 data open as name and unpack as they are read.
+	2026-10-18 v0.17 - resident images
+		* With nitroFSSetResident(), an image small enough is read into RAM whole by nitroFSInit().
+	2026-10-18 v0.18 - more mounts
+		* Each devoptab carries its mount in deviceData, nitroFSMount() adds any .nds under its own
+		  device name and nitroFSUnmount() takes it away again. A name already in use is refused,
+		  AddDevice() would replace that device. Separate mounts can be read from separate threads,
+		  but a mount's file position, block cache and stats aren't locked, so one mount is only
+		  safe to use from one thread at a time.
+	2026-10-18 v0.19 - host build
+		* __itcm and NITRONOCASHID can come from the build, so tools/ compiles this file for the
+		  host tests and bench_nitrofs against a stand-in for libnds.
 */
 
 #include "nitrofs.h"
@@ -49,18 +73,35 @@
 #include "tonccpy.h"
 
 #include <errno.h>
+#include <malloc.h>
 #include <nds.h>
+#include <stdlib.h>
 #include <string.h>
 
+#ifndef __itcm
 #define __itcm __attribute__((section(".itcm")))
+#endif
 
-// Globals!
-u32 fntOffset;   // offset to start of filename table
-u32 fatOffset;   // offset to start of file alloc table
-bool hasLoader;  // single global nds filehandle (is null if not in dldi/fat mode)
-u16 chdirpathid; // default dir path id...
-FILE *ndsFile;
-off_t ndsFileLastpos; // Used to determine need to fseek or not
+// no$gba leaves its name here, a host build points it at a string of its own
+#ifndef NITRONOCASHID
+#define NITRONOCASHID ((const char *)0x4FFFA00)
+#endif
+
+// The mount nitroFSInit() sets up as nitro:. Everything about an image lives in its nitroMount,
+// which the devoptab hands back through r->deviceData, so mounts never share any state.
+struct nitroMount nitroMain;
+
+// An image mounted by nitroFSMount(), with its own copy of the devoptab
+struct nitroDevice {
+	devoptab_t devoptab;
+	struct nitroMount mnt;
+	char name[NITRODEVNAMEMAX];
+};
+
+// Cache shape used by the next mount, see nitroFSSetCache()
+int cacheWantCount = NITROCACHEBLOCKS;
+u32 cacheWantSize  = NITROCACHEBLOCKSIZE;
+u32 residentMax    = 0; // biggest image nitroFSInit() will hold in RAM, see nitroFSSetResident()
 
 devoptab_t nitroFSdevoptab = {
 	"nitro",                      //	const char *name;
@@ -85,45 +126,477 @@ devoptab_t nitroFSdevoptab = {
 
 };
 
-// K, i decided to inline these, improves speed slightly..
-// these 2 'sub' functions deal with actually reading from either gba rom or .nds file :)
-// what i rly rly rly wanna know is how an actual nds cart reads from itself, but it seems no one can tell me ~_~
-// so, instead we have this weird weird haxy try gbaslot then try dldi method. If i (or you!!) ever do figure out
-// how to read the proper way can replace these 4 functions and everything should work normally :)
-
-// reads from rom image either gba rom or dldi
-inline ssize_t nitroSubRead(off_t *npos, void *ptr, size_t len) {
-	if(ndsFile != NULL) { // read from ndsfile
-		if(ndsFileLastpos != *npos)
-			fseek(ndsFile, *npos, SEEK_SET); // if we need to, move! (might want to verify this succeed)
-		len = fread(ptr, 1, len, ndsFile);
-	} else { // reading from gbarom
-		tonccpy(ptr,
-				*npos + (void *)GBAROM,
-				len); // len isnt checked here because other checks exist in the callers (hopefully)
-	}
-	if(len > 0)
-		*npos += len;
-	ndsFileLastpos = *npos; // save the current file nds pos
+// raw read from the .nds file, only seeks when the last read didnt end where this one starts
+ssize_t nitroFileRead(struct nitroMount *mnt, off_t pos, void *ptr, size_t len) {
+	if(mnt->lastpos != pos) {
+		fseek(mnt->file, pos, SEEK_SET); // if we need to, move! (might want to verify this succeed)
+		mnt->stats.deviceSeeks++;
+	}
+	len          = fread(ptr, 1, len, mnt->file);
+	mnt->lastpos = pos + len; // save the current file nds pos
+	mnt->stats.deviceReads++;
+	mnt->stats.deviceBytes += len;
 	return (len);
 }
 
-// seek around
-inline void nitroSubSeek(off_t *npos, int pos, int dir) {
-	if((dir == SEEK_SET) || (dir == SEEK_END)) // otherwise just set the pos :)
-		*npos = pos;
-	else if(dir == SEEK_CUR)
-		*npos += pos; // see ez!
+static void nitroCacheFree(struct nitroMount *mnt) {
+	if(mnt->cacheBlocks != NULL) {
+		free(mnt->cacheBlocks[0].data);
+		free(mnt->cacheBlocks);
+	}
+	mnt->cacheBlocks = NULL;
+	mnt->cacheCount  = 0;
+}
+
+// allocates the blocks asked for by nitroFSSetCache(), no cache at all if that fails
+static void nitroCacheAlloc(struct nitroMount *mnt) {
+	nitroCacheFree(mnt);
+	if(cacheWantCount <= 0)
+		return;
+	struct nitroCacheBlock *blocks = calloc(cacheWantCount, sizeof(struct nitroCacheBlock));
+	u8 *data                       = memalign(32, cacheWantCount * cacheWantSize);
+	if(blocks == NULL || data == NULL) {
+		free(blocks);
+		free(data);
+		return;
+	}
+	for(int i = 0; i < cacheWantCount; i++) {
+		blocks[i].start = -1;
+		blocks[i].data  = data + i * cacheWantSize;
+	}
+	mnt->cacheBlocks    = blocks;
+	mnt->cacheCount     = cacheWantCount;
+	mnt->cacheBlockSize = cacheWantSize;
+}
+
+// finds the block starting at start, reading it into the least recently used slot on a miss
+static struct nitroCacheBlock *nitroCacheGet(struct nitroMount *mnt, off_t start) {
+	struct nitroCacheBlock *victim = &mnt->cacheBlocks[0];
+	for(int i = 0; i < mnt->cacheCount; i++) {
+		if(mnt->cacheBlocks[i].start == start) {
+			mnt->stats.hits++;
+			mnt->cacheBlocks[i].used = ++mnt->cacheClock;
+			return (&mnt->cacheBlocks[i]);
+		}
+		if(mnt->cacheBlocks[i].used < victim->used)
+			victim = &mnt->cacheBlocks[i];
+	}
+	mnt->stats.misses++;
+	victim->start = start;
+	victim->len   = nitroFileRead(mnt, start, victim->data, mnt->cacheBlockSize);
+	victim->used  = ++mnt->cacheClock;
+	return (victim);
+}
+
+ssize_t nitroCacheRead(struct nitroMount *mnt, off_t pos, u8 *ptr, size_t len) {
+	size_t done = 0;
+	while(done < len) {
+		off_t at   = pos + done;
+		u32 offset = at % mnt->cacheBlockSize;
+		size_t n   = len - done;
+		if(offset == 0 && n >= mnt->cacheBlockSize) { // whole blocks skip the cache, theres nothing to gain copying them twice
+			n -= n % mnt->cacheBlockSize;
+			size_t got = nitroFileRead(mnt, at, ptr + done, n);
+			done += got;
+			if(got < n)
+				break;
+			continue;
+		}
+		struct nitroCacheBlock *block = nitroCacheGet(mnt, at - offset);
+		if(block->len <= offset) // past the end of the image
+			break;
+		if(n > block->len - offset)
+			n = block->len - offset;
+		memcpy(ptr + done, block->data + offset, n);
+		done += n;
+	}
+	return (done);
+}
+
+int nitroFSSetCache(int blocks, u32 blockSize) {
+	if(blocks < 0 || blockSize < 0x200 || (blockSize & 0x1ff))
+		return (0); // has to be whole sectors
+	cacheWantCount = blocks;
+	cacheWantSize  = blockSize;
+	if(nitroMain.file != NULL)
+		nitroCacheAlloc(&nitroMain);
+	return (1);
+}
+
+void nitroFSSetResident(u32 maxSize) { residentMax = maxSize; }
+
+void nitroFSGetCacheStats(struct nitroCacheStats *stats) {
+	*stats          = nitroMain.stats;
+	stats->resident = nitroMain.imageSize;
+}
+
+void nitroFSResetCacheStats(void) { memset(&nitroMain.stats, 0, sizeof(nitroMain.stats)); }
+
+// pread for the image: reads len bytes at pos from either the gba rom or the .nds file. Nothing
+// but the mount's own fseek bookkeeping is shared, so any number of handles can read in any order,
+// from one thread at a time.
+ssize_t nitroPread(struct nitroMount *mnt, off_t pos, void *ptr, size_t len) {
+	if((mnt->image != NULL) && (pos >= mnt->imageStart) && (pos + len <= mnt->imageStart + mnt->imageSize)) {
+		memcpy(ptr, mnt->image + (pos - mnt->imageStart), len); // resident, no card access at all
+		return (len);
+	}
+	if(mnt->file != NULL) { // read from ndsfile
+		if(mnt->cacheCount > 0)
+			return (nitroCacheRead(mnt, pos, ptr, len));
+		return (nitroFileRead(mnt, pos, ptr, len));
+	}
+	// reading from gbarom
+	tonccpy(ptr, pos + (void *)GBAROM, len); // len isnt checked here because other checks exist in the callers (hopefully)
+	return (len);
+}
+
+// Streaming LZ77 (the BIOS's type 0x10) decoder. Each flag byte says, high bit first, whether the
+// next 8 items are literal bytes or 2 byte back references into the last 4KB unpacked.
+struct nitroLz *nitroLzOpen(off_t start, off_t end, u32 size) {
+	struct nitroLz *lz = malloc(sizeof(struct nitroLz));
+	if(lz == NULL)
+		return (NULL);
+	lz->start = start + sizeof(u32); // past the header
+	lz->end   = end;
+	lz->size  = size;
+	nitroLzReset(lz);
+	return (lz);
+}
+
+void nitroLzReset(struct nitroLz *lz) {
+	lz->in      = lz->start;
+	lz->out     = 0;
+	lz->flags   = 0;
+	lz->bits    = 0;
+	lz->copyLen = 0;
+	lz->inLen   = 0;
+	lz->inAt    = 0;
+}
+
+// next compressed byte, -1 at the end of the data
+static int nitroLzByte(struct nitroMount *mnt, struct nitroLz *lz) {
+	if(lz->inAt == lz->inLen) {
+		size_t n = (lz->end - lz->in < (off_t)sizeof(lz->inBuf)) ? (size_t)(lz->end - lz->in) : sizeof(lz->inBuf);
+		ssize_t got = (n > 0) ? nitroPread(mnt, lz->in, lz->inBuf, n) : 0;
+		if(got <= 0)
+			return (-1);
+		lz->in += got;
+		lz->inLen = got;
+		lz->inAt  = 0;
+	}
+	return (lz->inBuf[lz->inAt++]);
+}
+
+// unpacks up to len bytes into dst (or nowhere if dst is NULL), returns how many
+size_t nitroLzDecode(struct nitroMount *mnt, struct nitroLz *lz, u8 *dst, size_t len) {
+	size_t done = 0;
+	while((done < len) && (lz->out < lz->size)) {
+		int c;
+		if(lz->copyLen > 0) {
+			c = lz->window[(lz->out - lz->copyDist) & (NITROLZWINDOW - 1)];
+			lz->copyLen--;
+		} else {
+			if(lz->bits == 0) {
+				if((c = nitroLzByte(mnt, lz)) < 0)
+					break;
+				lz->flags = c;
+				lz->bits  = 8;
+			}
+			bool ref = lz->flags & 0x80;
+			lz->flags <<= 1;
+			lz->bits--;
+			if(ref) {
+				int hi = nitroLzByte(mnt, lz);
+				int lo = nitroLzByte(mnt, lz);
+				if(lo < 0)
+					break;
+				lz->copyLen  = (hi >> 4) + 3;
+				lz->copyDist = (((hi & 0xf) << 8) | lo) + 1;
+				continue;
+			}
+			if((c = nitroLzByte(mnt, lz)) < 0)
+				break;
+		}
+		lz->window[lz->out++ & (NITROLZWINDOW - 1)] = c;
+		if(dst != NULL)
+			dst[done] = c;
+		done++;
+	}
+	return (done);
+}
+
+#define NITROHASHEMPTY 0xffff
+
+// FNV-1a over the parent dir id and the name
+static u32 nitroHashName(u16 parent, const char *name, size_t len) {
+	u32 hash = 2166136261u;
+	hash     = (hash ^ (parent & 0xff)) * 16777619u;
+	hash     = (hash ^ (parent >> 8)) * 16777619u;
+	for(size_t i = 0; i < len; i++)
+		hash = (hash ^ (u8)name[i]) * 16777619u;
+	return (hash);
+}
+
+static struct nitroNode *nitroGetNode(struct nitroMount *mnt, u16 id) {
+	if(id >= NITROROOT)
+		return (&mnt->dirNodes[id & NITRODIRMASK]);
+	return (&mnt->fileNodes[id]);
+}
+
+// finds the file or dir called name inside dir parent, -1 if there isnt one
+static int nitroLookup(struct nitroMount *mnt, u16 parent, const char *name, size_t len) {
+	if(len > NITROISDIR - 1)
+		return (-1);
+	u32 i = nitroHashName(parent, name, len) & mnt->nameHashMask;
+	for(; mnt->nameHash[i] != NITROHASHEMPTY; i = (i + 1) & mnt->nameHashMask) {
+		struct nitroNode *node = nitroGetNode(mnt, mnt->nameHash[i]);
+		if((node->parent == parent) && (node->len == len) && (memcmp(mnt->fntData + node->name, name, len) == 0))
+			return (mnt->nameHash[i]);
+	}
+	return (-1);
+}
+
+static u16 nitroParent(struct nitroMount *mnt, u16 dir) {
+	if((dir & NITRODIRMASK) == 0)
+		return (NITROROOT); // root is its own parent
+	return (((struct ROM_FNTDir *)mnt->fntData)[dir & NITRODIRMASK].parent_id);
+}
+
+// walks a path through the hash, no file access. returns the file or dir id, -1 if not found
+static int nitroResolve(struct nitroMount *mnt, const char *path) {
+	const char *cptr;
+	if((cptr = strchr(path, ':')))
+		path = cptr + 1; // move path past any device names
+	int id = (*path == '/') ? NITROROOT : mnt->chdirpathid;
+	while(*path) {
+		while(*path == '/')
+			path++; // move past any leading / or // together
+		if(*path == 0)
+			break;
+		size_t len = ((cptr = strchr(path, '/'))) ? (size_t)(cptr - path) : strlen(path);
+		if(id < NITROROOT)
+			return (-1); // a file cant have anything below it
+		if((len == 1) && (path[0] == '.')) {
+			// stay here
+		} else if((len == 2) && (path[0] == '.') && (path[1] == '.')) {
+			id = nitroParent(mnt, id);
+		} else if((id = nitroLookup(mnt, id, path, len)) < 0) {
+			return (-1);
+		}
+		path += len;
+	}
+	return (id);
+}
+
+static void nitroFreeIndex(struct nitroMount *mnt) {
+	free(mnt->fntData);
+	free(mnt->fatData);
+	free(mnt->fileNodes);
+	free(mnt->dirNodes);
+	free(mnt->nameHash);
+	free(mnt->lzSize);
+	mnt->lzSize    = NULL;
+	mnt->fntData   = NULL;
+	mnt->fatData   = NULL;
+	mnt->fileNodes = NULL;
+	mnt->dirNodes  = NULL;
+	mnt->nameHash  = NULL;
+	mnt->fntSize = mnt->fatCount = mnt->dirCount = 0;
+}
+
+static bool nitroAddNode(struct nitroMount *mnt, u16 id, u16 parent, u32 name, u8 len) {
+	if((id >= NITROROOT) ? ((id & NITRODIRMASK) >= mnt->dirCount) : (id >= mnt->fatCount))
+		return (false);
+	struct nitroNode *node = nitroGetNode(mnt, id);
+	node->name             = name;
+	node->parent           = parent;
+	node->len              = len;
+	u32 i                  = nitroHashName(parent, (const char *)mnt->fntData + name, len) & mnt->nameHashMask;
+	while(mnt->nameHash[i] != NITROHASHEMPTY)
+		i = (i + 1) & mnt->nameHashMask;
+	mnt->nameHash[i] = id;
+	return (true);
+}
+
+// where file id starts in the image
+static off_t nitroFileStart(struct nitroMount *mnt, u16 id) {
+	return (mnt->fatData[id].top + (mnt->hasLoader ? LOADEROFFSET : 0));
+}
+
+// uncompressed size of file id
+static u32 nitroFileSize(struct nitroMount *mnt, u16 id) {
+	if((mnt->lzSize != NULL) && mnt->lzSize[id])
+		return (mnt->lzSize[id]);
+	return (mnt->fatData[id].bottom - mnt->fatData[id].top);
+}
+
+// A file named *.lz holding LZ77 data (type 0x10 header) is served under its name without the
+// .lz, decompressed as its read. lzSize is the side table of those files, their unpacked size by id.
+static bool nitroCheckLz(struct nitroMount *mnt, u16 id, const char *name, u8 len) {
+	u32 header = 0;
+	if((len <= 3) || (memcmp(name + len - 3, ".lz", 3) != 0) ||
+	   (mnt->fatData[id].bottom - mnt->fatData[id].top <= sizeof(header)))
+		return (false);
+	nitroPread(mnt, nitroFileStart(mnt, id), &header, sizeof(header));
+	if(((header & 0xff) != NITROLZTYPE) || ((header >> 8) == 0))
+		return (false);
+	if((mnt->lzSize == NULL) && ((mnt->lzSize = calloc(mnt->fatCount, sizeof(u32))) == NULL))
+		return (false); // stays a plain file if theres no memory for the table
+	mnt->lzSize[id] = header >> 8;
+	return (true);
+}
+
+static void nitroFreeResident(struct nitroMount *mnt) {
+	free(mnt->image);
+	mnt->image      = NULL;
+	mnt->imageStart = 0;
+	mnt->imageSize  = 0;
+}
+
+// Reads everything nitrofs can touch after the header (FNT, FAT and all file data) into one block
+// with one fread, so reads become a memcpy. Keeps reading from the file if the block wont fit.
+static bool nitroLoadResident(struct nitroMount *mnt) {
+	off_t start = (mnt->fntOffset < mnt->fatOffset) ? mnt->fntOffset : mnt->fatOffset;
+	off_t end   = mnt->fatOffset + mnt->fatCount * sizeof(struct ROM_FAT);
+	if(end < mnt->fntOffset + mnt->fntSize)
+		end = mnt->fntOffset + mnt->fntSize;
+	for(u32 i = 0; i < mnt->fatCount; i++) {
+		off_t top = nitroFileStart(mnt, i);
+		if(mnt->fatData[i].bottom <= mnt->fatData[i].top)
+			continue; // empty
+		if(top < start)
+			start = top;
+		if(top + (mnt->fatData[i].bottom - mnt->fatData[i].top) > end)
+			end = top + (mnt->fatData[i].bottom - mnt->fatData[i].top);
+	}
+	start &= ~0x1ff; // whole sectors
+	if((end - start) > residentMax)
+		return (false);
+	if((mnt->image = memalign(32, end - start)) == NULL)
+		return (false); // not enough memory, stay on the file
+	if(nitroFileRead(mnt, start, mnt->image, end - start) != end - start) {
+		free(mnt->image);
+		mnt->image = NULL;
+		return (false);
+	}
+	mnt->imageStart = start;
+	mnt->imageSize  = end - start;
+	nitroCacheFree(mnt); // nothing left for it to do
+	return (true);
+}
+
+// loads the FNT and FAT (sizes from the header at hdr) and hashes every name in them
+static bool nitroLoadIndex(struct nitroMount *mnt, u32 hdr) {
+	u32 fatSize;
+	nitroFreeIndex(mnt);
+	nitroPread(mnt, hdr + FNTSIZEOFFSET, &mnt->fntSize, sizeof(mnt->fntSize));
+	nitroPread(mnt, hdr + FATSIZEOFFSET, &fatSize, sizeof(fatSize));
+	mnt->fatCount = fatSize / sizeof(struct ROM_FAT);
+	if((mnt->fntSize < sizeof(struct ROM_FNTDir)) || (mnt->fatCount > NITROROOT))
+		return (false);
+	mnt->fntData = (u8 *)malloc(mnt->fntSize + 1);
+	mnt->fatData = (struct ROM_FAT *)malloc(mnt->fatCount * sizeof(struct ROM_FAT) + 1);
+	if(!mnt->fntData || !mnt->fatData) {
+		nitroFreeIndex(mnt);
+		return (false);
+	}
+	nitroPread(mnt, mnt->fntOffset, mnt->fntData, mnt->fntSize);
+	nitroPread(mnt, mnt->fatOffset, mnt->fatData, mnt->fatCount * sizeof(struct ROM_FAT));
+	mnt->fntData[mnt->fntSize] = 0; // makes a truncated table end in an end-of-table marker
+	struct ROM_FNTDir *dirs    = (struct ROM_FNTDir *)mnt->fntData;
+	mnt->dirCount              = dirs[0].parent_id; // the root's parent field holds the number of dirs
+	if((mnt->dirCount == 0) || (mnt->dirCount > NITRODIRMASK) || // dir id 0xffff would be NITROHASHEMPTY
+	   (mnt->dirCount * sizeof(struct ROM_FNTDir) > mnt->fntSize)) {
+		nitroFreeIndex(mnt);
+		return (false);
+	}
+	u32 nodeCount = mnt->fatCount + mnt->dirCount;
+	for(mnt->nameHashMask = 1; mnt->nameHashMask < nodeCount * 2; mnt->nameHashMask <<= 1)
+		;
+	mnt->fileNodes = (struct nitroNode *)malloc(mnt->fatCount * sizeof(struct nitroNode) + 1);
+	mnt->dirNodes  = (struct nitroNode *)calloc(mnt->dirCount, sizeof(struct nitroNode));
+	mnt->nameHash  = (u16 *)malloc(mnt->nameHashMask * sizeof(u16));
+	mnt->nameHashMask--;
+	if(!mnt->fileNodes || !mnt->dirNodes || !mnt->nameHash) {
+		nitroFreeIndex(mnt);
+		return (false);
+	}
+	memset(mnt->nameHash, 0xff, (mnt->nameHashMask + 1) * sizeof(u16));
+	const u8 *fnt = mnt->fntData;
+	u32 fntSize   = mnt->fntSize;
+	for(u16 d = 0; d < mnt->dirCount; d++) {
+		u32 namepos = dirs[d].entry_start;
+		u16 fileid  = dirs[d].entry_file_id;
+		u16 parent  = NITROROOT | d;
+		while((namepos < fntSize) && fnt[namepos]) {
+			u8 next  = fnt[namepos];
+			u8 len   = next & (NITROISDIR ^ 0xff);
+			u32 name = namepos + 1;
+			if(next & NITROISDIR) {
+				if(name + len + sizeof(u16) > fntSize)
+					break;
+				u16 dirid = fnt[name + len] | (fnt[name + len + 1] << 8);
+				if(!nitroAddNode(mnt, dirid, parent, name, len))
+					break;
+				namepos = name + len + sizeof(u16);
+			} else {
+				if(name + len > fntSize)
+					break;
+				if(fileid < mnt->fatCount && nitroCheckLz(mnt, fileid, (const char *)fnt + name, len))
+					len -= 3; // hashed without the .lz
+				if(!nitroAddNode(mnt, fileid++, parent, name, len))
+					break;
+				namepos = name + (next & (NITROISDIR ^ 0xff));
+			}
+		}
+	}
+	return (true);
+}
+
+static void nitroUnload(struct nitroMount *mnt) {
+	if(mnt->file != NULL)
+		fclose(mnt->file);
+	nitroCacheFree(mnt);
+	nitroFreeIndex(mnt);
+	nitroFreeResident(mnt);
+	memset(mnt, 0, sizeof(*mnt));
+	mnt->chdirpathid = NITROROOT;
+}
+
+// opens ndsfile into mnt, reads its offsets and loads the index
+static bool nitroLoadFile(struct nitroMount *mnt, const char *ndsfile) {
+	char romstr[0x10];
+	if((mnt->file = fopen(ndsfile, "rb")) == NULL)
+		return (false);
+	setvbuf(mnt->file, NULL, _IONBF, 0); // we dont need double buffs u_u, the block cache does it
+	nitroCacheAlloc(mnt);
+	nitroPread(mnt, 0, romstr, strlen(LOADERSTR));
+	if(strncmp(romstr, LOADERSTR, strlen(LOADERSTR)) == 0) {
+		nitroPread(mnt, LOADEROFFSET + FNTOFFSET, &mnt->fntOffset, sizeof(mnt->fntOffset));
+		nitroPread(mnt, LOADEROFFSET + FATOFFSET, &mnt->fatOffset, sizeof(mnt->fatOffset));
+		mnt->fatOffset += LOADEROFFSET;
+		mnt->fntOffset += LOADEROFFSET;
+		mnt->hasLoader = true;
+	} else {
+		nitroPread(mnt, FNTOFFSET, &mnt->fntOffset, sizeof(mnt->fntOffset));
+		nitroPread(mnt, FATOFFSET, &mnt->fatOffset, sizeof(mnt->fatOffset));
+		mnt->hasLoader = false;
+	}
+	if(nitroLoadIndex(mnt, mnt->hasLoader ? LOADEROFFSET : 0)) {
+		if(residentMax > 0)
+			nitroLoadResident(mnt);
+		return (true);
+	}
+	nitroUnload(mnt);
+	return (false);
 }
 
 // Figure out if its gba or ds, setup stuff
 int __itcm nitroFSInit(const char *ndsfile) {
-	off_t pos = 0;
-	char romstr[0x10];
-	chdirpathid    = NITROROOT;
-	ndsFileLastpos = 0;
-	ndsFile        = NULL;
-	bool noCashGba = (strncmp((const char *)0x4FFFA00, "no$gba", 6) == 0);
+	struct nitroMount *mnt = &nitroMain;
+	nitroUnload(mnt);
+	nitroFSdevoptab.deviceData = mnt;
+	bool noCashGba             = (strncmp(NITRONOCASHID, "no$gba", 6) == 0);
 	if(!isDSiMode() || noCashGba) {
 		sysSetCartOwner(BUS_OWNER_ARM9); // give us gba slot ownership
 		// We has gba rahm
@@ -131,18 +604,22 @@ int __itcm nitroFSInit(const char *ndsfile) {
 		if(strncmp(((const char *)GBAROM) + LOADERSTROFFSET, LOADERSTR, strlen(LOADERSTR)) ==
 		   0) { // Look for second magic string, if found its a sc.nds or nds.gba
 			// printf("sc/gba\n");
-			fntOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FNTOFFSET + LOADEROFFSET)) + LOADEROFFSET;
-			fatOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FATOFFSET + LOADEROFFSET)) + LOADEROFFSET;
-			hasLoader = true;
-			AddDevice(&nitroFSdevoptab);
-			return (1);
+			mnt->fntOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FNTOFFSET + LOADEROFFSET)) + LOADEROFFSET;
+			mnt->fatOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FATOFFSET + LOADEROFFSET)) + LOADEROFFSET;
+			mnt->hasLoader = true;
+			if(nitroLoadIndex(mnt, LOADEROFFSET)) {
+				AddDevice(&nitroFSdevoptab);
+				return (1);
+			}
 		} else if(noCashGba) { // Ok, its not a .gba build, so must be emulator
 			// printf("gba, must be emu\n");
-			fntOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FNTOFFSET));
-			fatOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FATOFFSET));
-			hasLoader = false;
-			AddDevice(&nitroFSdevoptab);
-			return (1);
+			mnt->fntOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FNTOFFSET));
+			mnt->fatOffset = ((u32) * (u32 *)(((const char *)GBAROM) + FATOFFSET));
+			mnt->hasLoader = false;
+			if(nitroLoadIndex(mnt, 0)) {
+				AddDevice(&nitroFSdevoptab);
+				return (1);
+			}
 		}
 	}
 	if(isDSiMode() && ndsfile == NULL) {
@@ -155,80 +632,98 @@ int __itcm nitroFSInit(const char *ndsfile) {
 				*(u8 *)0x02FFE01E);
 		ndsfile = fileName;
 	}
-	if(ndsfile != NULL) {
-		if((ndsFile = fopen(ndsfile, "rb"))) {
-			nitroSubRead(&pos, romstr, strlen(LOADERSTR));
-			if(strncmp(romstr, LOADERSTR, strlen(LOADERSTR)) == 0) {
-				nitroSubSeek(&pos, LOADEROFFSET + FNTOFFSET, SEEK_SET);
-				nitroSubRead(&pos, &fntOffset, sizeof(fntOffset));
-				nitroSubSeek(&pos, LOADEROFFSET + FATOFFSET, SEEK_SET);
-				nitroSubRead(&pos, &fatOffset, sizeof(fatOffset));
-				fatOffset += LOADEROFFSET;
-				fntOffset += LOADEROFFSET;
-				hasLoader = true;
-			} else {
-				nitroSubSeek(&pos, FNTOFFSET, SEEK_SET);
-				nitroSubRead(&pos, &fntOffset, sizeof(fntOffset));
-				nitroSubSeek(&pos, FATOFFSET, SEEK_SET);
-				nitroSubRead(&pos, &fatOffset, sizeof(fatOffset));
-				hasLoader = false;
-			}
-			setvbuf(ndsFile, NULL, _IONBF, 0); // we dont need double buffs u_u
-			AddDevice(&nitroFSdevoptab);
-			return (1);
-		}
+	if((ndsfile != NULL) && nitroLoadFile(mnt, ndsfile)) {
+		AddDevice(&nitroFSdevoptab);
+		return (1);
 	}
 	return (0);
 }
 
+// name with its colon, without one FindDevice answers with the default device
+static bool nitroDevName(char *devname, const char *name) {
+	if((name == NULL) || (strlen(name) == 0) || (strlen(name) >= NITRODEVNAMEMAX) || (strchr(name, ':') != NULL))
+		return (false);
+	sprintf(devname, "%s:", name);
+	return (true);
+}
+
+// Mounts the NitroFS of any .nds as device name (without the colon), next to nitro: and each other
+int nitroFSMount(const char *name, const char *ndsfile) {
+	char devname[NITRODEVNAMEMAX + 1];
+	if(!nitroDevName(devname, name) || (ndsfile == NULL))
+		return (0);
+	if(GetDeviceOpTab(devname) != NULL) // AddDevice would replace it
+		return (0);
+	struct nitroDevice *dev = calloc(1, sizeof(struct nitroDevice));
+	if(dev == NULL)
+		return (0);
+	nitroUnload(&dev->mnt);
+	if(!nitroLoadFile(&dev->mnt, ndsfile)) {
+		free(dev);
+		return (0);
+	}
+	strcpy(dev->name, name);
+	dev->devoptab            = nitroFSdevoptab;
+	dev->devoptab.name       = dev->name;
+	dev->devoptab.deviceData = &dev->mnt;
+	if(AddDevice(&dev->devoptab) < 0) {
+		nitroUnload(&dev->mnt);
+		free(dev);
+		return (0);
+	}
+	return (1);
+}
+
+// Removes a mount made by nitroFSMount(), files open on it have to be closed first
+int nitroFSUnmount(const char *name) {
+	char devname[NITRODEVNAMEMAX + 1];
+	if(!nitroDevName(devname, name))
+		return (0);
+	const devoptab_t *tab = GetDeviceOpTab(devname);
+	if((tab == NULL) || (tab->open_r != nitroFSOpen) || (tab->deviceData == &nitroMain))
+		return (0);
+	struct nitroDevice *dev = (struct nitroDevice *)tab; // devoptab is the first member
+	RemoveDevice(devname);
+	nitroUnload(&dev->mnt);
+	free(dev);
+	return (1);
+}
+
+// the mount a devoptab call is for
+static struct nitroMount *nitroReentMount(struct _reent *r) {
+	if((r != NULL) && (r->deviceData != NULL))
+		return ((struct nitroMount *)r->deviceData);
+	return (&nitroMain);
+}
+
+// the mount a path names by its device, nitro: if it names none. NULL if the device isnt nitrofs
+static struct nitroMount *nitroPathMount(const char *path) {
+	struct nitroMount *mnt = &nitroMain;
+	if(strchr(path, ':') != NULL) {
+		const devoptab_t *tab = GetDeviceOpTab(path);
+		if((tab == NULL) || (tab->open_r != nitroFSOpen))
+			return (NULL);
+		mnt = (struct nitroMount *)tab->deviceData;
+	}
+	if(mnt->nameHash == NULL) // nothing mounted there
+		return (NULL);
+	return (mnt);
+}
+
 // Directory functs
 DIR_ITER *nitroFSDirOpen(struct _reent *r, DIR_ITER *dirState, const char *path) {
 	struct nitroDIRStruct *dirStruct = (struct nitroDIRStruct *)dirState->dirStruct; // this makes it lots easier!
-	struct stat st;
-	char dirname[NITRONAMELENMAX];
-	char *cptr;
-	char mydirpath[NITROMAXPATHLEN]; // to hold copy of path string
-	char *dirpath = mydirpath;
-	bool pathfound;
-	if((cptr = strchr(path, ':')))
-		path = cptr + 1; // move path past any device names (if it was nixy style wouldnt need this step >_>)
-	strncpy(dirpath, path, sizeof(mydirpath) - 1); // copy the string (as im gonna mutalate it)
-	dirStruct->pos = 0;
-	if(*dirpath == '/')                    // if first character is '/' use absolute root path plz
-		dirStruct->cur_dir_id = NITROROOT; // first root dir
-	else
-		dirStruct->cur_dir_id = chdirpathid; // else use chdirpath
-	nitroDirReset(r, dirState);              // set dir to current path
-	do {
-		while((cptr = strchr(dirpath, '/')) == dirpath) {
-			dirpath++; // move past any leading / or // together
-		}
-		if(cptr)
-			*cptr = 0; // erase /
-		if(*dirpath ==
-		   0) { // are we at the end of the path string?? if so there is nothing to search for we're already here !
-			pathfound = true; // mostly this handles searches for root or /  or no path specified cases
-			break;
-		}
-		pathfound = false;
-		while(nitroFSDirNext(r, dirState, dirname, &st) == 0) {
-			if((st.st_mode == S_IFDIR) && !(strcmp(dirname, dirpath))) { // if its a directory and name matches dirpath
-				dirStruct->cur_dir_id = dirStruct->dir_id;               // move us to the next dir in tree
-				nitroDirReset(r, dirState);                              // set dir to current path we just found...
-				pathfound = true;
-				break;
-			}
-		};
-		if(!pathfound)
-			break;
-		dirpath = cptr + 1; // move to right after last / we found
-	} while(cptr);          // go till after the last /
-	if(pathfound) {
-		return (dirState);
-	} else {
+	struct nitroMount *mnt           = nitroReentMount(r);
+	int id                           = nitroResolve(mnt, path);
+	if(id < NITROROOT) { // not found, or its a file
 		r->_errno = ENOENT;
 		return (NULL);
 	}
+	dirStruct->mnt        = mnt;
+	dirStruct->pos        = 0;
+	dirStruct->cur_dir_id = id;
+	nitroDirReset(r, dirState); // set dir to the path we just found
+	return (dirState);
 }
 
 int nitroFSDirClose(struct _reent *r, DIR_ITER *dirState) { return (0); }
@@ -239,21 +734,19 @@ const char *syspaths[2] = {".", ".."};
 // reset dir to start of entry selected by dirStruct->cur_dir_id which should be set in dirOpen okai?!
 int nitroDirReset(struct _reent *r, DIR_ITER *dirState) {
 	struct nitroDIRStruct *dirStruct = (struct nitroDIRStruct *)dirState->dirStruct; // this makes it lots easier!
-	struct ROM_FNTDir dirsubtable;
-	off_t *pos = &dirStruct->pos;
-	nitroSubSeek(pos, fntOffset + ((dirStruct->cur_dir_id & NITRODIRMASK) * sizeof(struct ROM_FNTDir)), SEEK_SET);
-	nitroSubRead(pos, &dirsubtable, sizeof(dirsubtable));
-	dirStruct->namepos   = dirsubtable.entry_start;   // set namepos to first entry in this dir's table
-	dirStruct->entry_id  = dirsubtable.entry_file_id; // get number of first file ID in this branch
-	dirStruct->parent_id = dirsubtable.parent_id;     // save parent ID in case we wanna add ../ functionality
-	dirStruct->spc       = 0;                         // system path counter, first two dirnext's deliver . and ..
+	struct nitroMount *mnt           = dirStruct->mnt;
+	struct ROM_FNTDir *dirsubtable   = &((struct ROM_FNTDir *)mnt->fntData)[dirStruct->cur_dir_id & NITRODIRMASK];
+	dirStruct->namepos   = dirsubtable->entry_start;   // set namepos to first entry in this dir's table
+	dirStruct->entry_id  = dirsubtable->entry_file_id; // get number of first file ID in this branch
+	dirStruct->parent_id = nitroParent(mnt, dirStruct->cur_dir_id); // save parent ID in case we wanna add ../ functionality
+	dirStruct->spc       = 0; // system path counter, first two dirnext's deliver . and ..
 	return (0);
 }
 
 int nitroFSDirNext(struct _reent *r, DIR_ITER *dirState, char *filename, struct stat *st) {
 	unsigned char next;
 	struct nitroDIRStruct *dirStruct = (struct nitroDIRStruct *)dirState->dirStruct; // this makes it lots easier!
-	off_t *pos                       = &dirStruct->pos;
+	struct nitroMount *mnt           = dirStruct->mnt;
 	if(dirStruct->spc <= 1) {
 		if(st)
 			st->st_mode = S_IFDIR;
@@ -265,38 +758,39 @@ int nitroFSDirNext(struct _reent *r, DIR_ITER *dirState, char *filename, struct
 		strcpy(filename, syspaths[dirStruct->spc++]);
 		return (0);
 	}
-	nitroSubSeek(pos, fntOffset + dirStruct->namepos, SEEK_SET);
-	nitroSubRead(pos, &next, sizeof(next));
 	// next: high bit 0x80 = entry isdir.. other 7 bits r size, the 16 bits following name are dir's entryid (starts
 	// with f000)
 	//  00 = endoftable //
+	next = (dirStruct->namepos < mnt->fntSize) ? mnt->fntData[dirStruct->namepos] : 0;
 	if(next) {
+		const u8 *name = mnt->fntData + dirStruct->namepos + 1;
 		if(next & NITROISDIR) {
 			if(st)
 				st->st_mode = S_IFDIR;
 			next &= NITROISDIR ^ 0xff; // invert bits and mask off 0x80
-			nitroSubRead(pos, filename, next);
-			nitroSubRead(
-				&dirStruct->pos,
-				&dirStruct->dir_id,
-				sizeof(
-					dirStruct->dir_id)); // read the dir_id
-										 // grr cant get the struct member size?, just wanna test it so moving on...
-										 //			nitroSubRead(pos,&dirStruct->dir_id,sizeof(u16)); //read the dir_id
-			dirStruct->namepos += next + sizeof(u16) + 1; // now we points to next one plus dir_id size:D
+			if(dirStruct->namepos + 1 + next + sizeof(u16) > mnt->fntSize) {
+				r->_errno = EIO;
+				return (-1);
+			}
+			memcpy(filename, name, next);
+			dirStruct->dir_id = name[next] | (name[next + 1] << 8); // read the dir_id
+			dirStruct->namepos += next + sizeof(u16) + 1;           // now we points to next one plus dir_id size:D
 		} else {
 			if(st)
 				st->st_mode = 0;
-			nitroSubRead(pos, filename, next);
+			if((dirStruct->namepos + 1 + next > mnt->fntSize) || (dirStruct->entry_id >= mnt->fatCount)) {
+				r->_errno = EIO;
+				return (-1);
+			}
+			memcpy(filename, name, next);
 			dirStruct->namepos += next + 1; // now we points to next one :D
-			// read file info to get filesize (and for fileopen)
-			nitroSubSeek(pos, fatOffset + (dirStruct->entry_id * sizeof(struct ROM_FAT)), SEEK_SET);
-			nitroSubRead(pos,
-						 &dirStruct->romfat,
-						 sizeof(dirStruct->romfat)); // retrieve romfat entry (contains filestart and end positions)
-			dirStruct->entry_id++;                   // advance ROM_FNTStrFile ptr
+			// file info to get filesize (and for fileopen)
+			dirStruct->romfat = mnt->fatData[dirStruct->entry_id]; // romfat entry (contains filestart and end positions)
+			if((mnt->lzSize != NULL) && mnt->lzSize[dirStruct->entry_id])
+				next -= 3; // compressed, list it without the .lz
 			if(st)
-				st->st_size = dirStruct->romfat.bottom - dirStruct->romfat.top; // calculate filesize
+				st->st_size = nitroFileSize(mnt, dirStruct->entry_id); // calculate filesize
+			dirStruct->entry_id++; // advance ROM_FNTStrFile ptr
 		}
 		filename[(int)next] = 0; // zero last char
 		return (0);
@@ -309,79 +803,99 @@ int nitroFSDirNext(struct _reent *r, DIR_ITER *dirState, char *filename, struct
 // fs functs
 int nitroFSOpen(struct _reent *r, void *fileStruct, const char *path, int flags, int mode) {
 	struct nitroFSStruct *fatStruct = (struct nitroFSStruct *)fileStruct;
-	struct nitroDIRStruct dirStruct;
-	DIR_ITER dirState;
-	dirState.dirStruct = &dirStruct; // create a temp dirstruct
-	struct _reent dre;
-	struct stat st;                         // all these are just used for reading the dir ~_~
-	char dirfilename[NITROMAXPATHLEN];      // to hold a full path (i tried to avoid using so much stack but blah :/)
-	char *filename;                         // to hold filename
-	char *cptr;                             // used to string searching and manipulation
-	cptr     = (char *)path + strlen(path); // find the end...
-	filename = NULL;
-	do {
-		if((*cptr == '/') || (*cptr == ':')) { // split at either / or : (whichever comes first form the end!)
-			cptr++;
-			strncpy(dirfilename, path, cptr - path); // copy string up till and including/ or : zero rest
-			dirfilename[cptr - path] = 0;            // it seems strncpy doesnt always zero?!
-			filename                 = cptr;         // filename = now remainder of string
-			break;
-		}
-	} while(cptr-- != path);           // search till start
-	if(!filename) {                    // we didnt find a / or : ? shouldnt realyl happen but if it does...
-		filename       = (char *)path; // filename = complete path
-		dirfilename[0] = 0;            // make directory path ""
+	struct nitroMount *mnt          = nitroReentMount(r);
+	int id                          = nitroResolve(mnt, path);
+	if((id < 0) || (id >= NITROROOT)) { // not found, or its a dir
+		if(r)
+			r->_errno = ENOENT;
+		return (-1); // teh fail
 	}
-	if(nitroFSDirOpen(&dre, &dirState, dirfilename)) {
-		fatStruct->start = 0;
-		while(nitroFSDirNext(&dre, &dirState, dirfilename, &st) == 0) {
-			if(!(st.st_mode & S_IFDIR) && (strcmp(dirfilename, filename) == 0)) { // Found the *file* youre looking
-																				  // for!!
-				fatStruct->start = dirStruct.romfat.top;
-				fatStruct->end   = dirStruct.romfat.bottom;
-				if(hasLoader) {
-					fatStruct->start += LOADEROFFSET;
-					fatStruct->end += LOADEROFFSET;
-				}
-				break;
-			}
+	fatStruct->mnt   = mnt;
+	fatStruct->start = nitroFileStart(mnt, id);
+	fatStruct->end   = fatStruct->start + (mnt->fatData[id].bottom - mnt->fatData[id].top);
+	fatStruct->lz    = NULL;
+	if((mnt->lzSize != NULL) && mnt->lzSize[id]) {
+		// positions of a compressed file count unpacked bytes, the raw range goes to the decoder
+		if((fatStruct->lz = nitroLzOpen(fatStruct->start, fatStruct->end, mnt->lzSize[id])) == NULL) {
+			if(r)
+				r->_errno = ENOMEM;
+			return (-1);
 		}
-		if(fatStruct->start) {
-			nitroSubSeek(&fatStruct->pos, fatStruct->start, SEEK_SET); // seek to start of file
-			return (0);                                                // woot!
-		}
-		nitroFSDirClose(&dre, &dirState);
-	}
-	if(r->_errno == 0) {
-		r->_errno = ENOENT;
+		fatStruct->start = 0;
+		fatStruct->end   = mnt->lzSize[id];
 	}
-	return (-1); // teh fail
+	fatStruct->pos      = fatStruct->start; // seek to start of file
+	fatStruct->bufStart = 0;
+	fatStruct->bufLen   = 0; // nothing buffered yet
+	return (0);              // woot!
 }
 
-int nitroFSClose(struct _reent *r, void *fd) { return (0); }
+int nitroFSClose(struct _reent *r, void *fd) {
+	free(((struct nitroFSStruct *)fd)->lz);
+	return (0);
+}
 
+// Each handle keeps the last NITROHANDLEBUF bytes it read around, so handles read in small pieces
+// side by side mostly stay out of the shared cache and never move each others file position.
 ssize_t nitroFSRead(struct _reent *r, void *fd, char *ptr, size_t len) {
 	struct nitroFSStruct *fatStruct = (struct nitroFSStruct *)fd;
-	off_t *npos                     = &fatStruct->pos;
-	if(*npos + len > fatStruct->end)
-		len = fatStruct->end - *npos; // dont let us read past the end plz!
-	if(*npos > fatStruct->end)
+	struct nitroMount *mnt          = fatStruct->mnt;
+	off_t pos                       = fatStruct->pos;
+	if(pos >= fatStruct->end)
 		return (0); // hit eof
-	return (nitroSubRead(npos, ptr, len));
+	if(pos + len > fatStruct->end)
+		len = fatStruct->end - pos; // dont let us read past the end plz!
+	if(fatStruct->lz != NULL) {
+		if(pos < fatStruct->lz->out)
+			nitroLzReset(fatStruct->lz); // going back means unpacking again from the start
+		while(fatStruct->lz->out < pos) { // and going forward unpacks whats skipped
+			if(nitroLzDecode(mnt, fatStruct->lz, NULL, pos - fatStruct->lz->out) == 0)
+				return (0);
+		}
+		size_t done = nitroLzDecode(mnt, fatStruct->lz, (u8 *)ptr, len);
+		fatStruct->pos += done;
+		return (done);
+	}
+	size_t done = 0;
+	if((pos >= fatStruct->bufStart) && (pos < fatStruct->bufStart + fatStruct->bufLen)) {
+		done = fatStruct->bufStart + fatStruct->bufLen - pos;
+		if(done > len)
+			done = len;
+		memcpy(ptr, fatStruct->buf + (pos - fatStruct->bufStart), done);
+	}
+	if(done < len) {
+		size_t left = len - done;
+		if((mnt->file == NULL) || (mnt->image != NULL) || (left >= NITROHANDLEBUF)) { // memory mapped, or too big to be worth buffering
+			done += nitroPread(mnt, pos + done, ptr + done, left);
+		} else {
+			off_t at  = pos + done;
+			size_t n  = (fatStruct->end - at < NITROHANDLEBUF) ? (size_t)(fatStruct->end - at) : NITROHANDLEBUF;
+			ssize_t got = nitroPread(mnt, at, fatStruct->buf, n);
+			fatStruct->bufStart = at;
+			fatStruct->bufLen   = (got > 0) ? got : 0;
+			if(left > fatStruct->bufLen)
+				left = fatStruct->bufLen;
+			memcpy(ptr + done, fatStruct->buf, left);
+			done += left;
+		}
+	}
+	fatStruct->pos += done;
+	return (done);
 }
 
 off_t nitroFSSeek(struct _reent *r, void *fd, off_t pos, int dir) {
 	// need check for eof here...
 	struct nitroFSStruct *fatStruct = (struct nitroFSStruct *)fd;
-	off_t *npos                     = &fatStruct->pos;
 	if(dir == SEEK_SET)
 		pos += fatStruct->start; // add start from .nds file offset
 	else if(dir == SEEK_END)
 		pos += fatStruct->end; // set start to end of file (useless?)
+	else if(dir == SEEK_CUR)
+		pos += fatStruct->pos; // see ez!
 	if(pos > fatStruct->end)
 		return (-1); // dont let us read past the end plz!
-	nitroSubSeek(npos, pos, dir);
-	return (*npos - fatStruct->start);
+	fatStruct->pos = pos;
+	return (fatStruct->pos - fatStruct->start);
 }
 
 int nitroFSFstat(struct _reent *r, void *fd, struct stat *st) {
@@ -391,36 +905,85 @@ int nitroFSFstat(struct _reent *r, void *fd, struct stat *st) {
 }
 
 int nitroFSstat(struct _reent *r, const char *file, struct stat *st) {
-	struct nitroFSStruct fatStruct;
-	struct nitroDIRStruct dirStruct;
-	DIR_ITER dirState;
-
-	if(nitroFSOpen(NULL, &fatStruct, file, 0, 0) >= 0) {
-		st->st_mode = S_IFREG;
-		st->st_size = fatStruct.end - fatStruct.start;
-		return (0);
+	struct nitroMount *mnt = nitroReentMount(r);
+	int id                 = nitroResolve(mnt, file);
+	if(id < 0) {
+		r->_errno = ENOENT;
+		return (-1);
 	}
-
-	dirState.dirStruct = &dirStruct;
-	if((nitroFSDirOpen(r, &dirState, file) != NULL)) {
+	if(id >= NITROROOT) {
 		st->st_mode = S_IFDIR;
-		nitroFSDirClose(r, &dirState);
-		return (0);
+	} else {
+		st->st_mode = S_IFREG;
+		st->st_size = nitroFileSize(mnt, id);
 	}
-	r->_errno = ENOENT;
-	return (-1);
+	return (0);
 }
 
 int nitroFSChdir(struct _reent *r, const char *name) {
-	struct nitroDIRStruct dirStruct;
-	DIR_ITER dirState;
-	dirState.dirStruct = &dirStruct;
-	if((name != NULL) && (nitroFSDirOpen(r, &dirState, name) != NULL)) {
-		chdirpathid = dirStruct.cur_dir_id;
-		nitroFSDirClose(r, &dirState);
+	struct nitroMount *mnt = nitroReentMount(r);
+	int id                 = (name != NULL) ? nitroResolve(mnt, name) : -1;
+	if(id >= NITROROOT) {
+		mnt->chdirpathid = id;
 		return (0);
 	} else {
 		r->_errno = ENOENT;
 		return (-1);
 	}
 }
+
+// Copies a whole nitro file into dst. The file is just a byte range of the image, so it's read
+// straight from the mount in big sector aligned pieces without going through the devoptab or
+// a file handle. hash (if not NULL) is fed every piece on the way. returns bytes copied, -1 on error
+ssize_t nitroFSExport(const char *path, FILE *dst, nitroHashFunc hash, void *hashCtx) {
+	struct nitroMount *mnt = nitroPathMount(path);
+	if(mnt == NULL) {
+		errno = ENODEV;
+		return (-1);
+	}
+	int id = nitroResolve(mnt, path);
+	if((id < 0) || (id >= NITROROOT) || (dst == NULL)) {
+		errno = (dst == NULL) ? EINVAL : (id >= NITROROOT) ? EISDIR : ENOENT;
+		return (-1);
+	}
+	off_t pos = nitroFileStart(mnt, id);
+	off_t end = pos + (mnt->fatData[id].bottom - mnt->fatData[id].top);
+	struct nitroLz *lz = NULL;
+	if((mnt->lzSize != NULL) && mnt->lzSize[id]) { // unpack it on the way instead
+		if((lz = nitroLzOpen(pos, end, mnt->lzSize[id])) == NULL) {
+			errno = ENOMEM;
+			return (-1);
+		}
+		pos = 0;
+		end = mnt->lzSize[id];
+	}
+	u8 *buf = memalign(32, NITROEXPORTCHUNK);
+	if(buf == NULL) {
+		free(lz);
+		errno = ENOMEM;
+		return (-1);
+	}
+	ssize_t total = 0;
+	while(pos < end) {
+		size_t len = NITROEXPORTCHUNK - (pos & 0x1ff); // the first piece ends on a sector, the rest start on one
+		if(len > end - pos)
+			len = end - pos;
+		ssize_t got = (lz != NULL) ? (ssize_t)nitroLzDecode(mnt, lz, buf, len) : nitroPread(mnt, pos, buf, len);
+		if(got <= 0) {
+			errno = EIO;
+			total = -1;
+			break;
+		}
+		if(fwrite(buf, 1, got, dst) != (size_t)got) { // fwrite has set errno
+			total = -1;
+			break;
+		}
+		if(hash != NULL)
+			hash(hashCtx, buf, got);
+		pos += got;
+		total += got;
+	}
+	free(buf);
+	free(lz);
+	return (total);
+}
@@ -26,6 +26,20 @@
 #include "main.h"
 #include "storage.h"
 
+bool isRomFile(char const* fname)
+{
+	if (!fname) return false;
+
+	return (strstr(fname, ".nds") != NULL ||
+			strstr(fname, ".ids") != NULL ||
+			strstr(fname, ".app") != NULL ||
+			strstr(fname, ".dsi") != NULL ||
+			strstr(fname, ".NDS") != NULL ||
+			strstr(fname, ".APP") != NULL ||
+			strstr(fname, ".DSI") != NULL ||
+			strstr(fname, ".IDS") != NULL);
+}
+
 tDSiHeader* getRomHeader(char const* fpath)
 {
 	if (!fpath) return NULL;
@@ -0,0 +1,218 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <ctype.h>
+
+#include <nds.h>
+
+#include "main.h"
+#include "rom.h"
+#include "menu.h"
+#include "message.h"
+#include "library.h"
+
+#define SEARCH_MAX_RESULTS 500
+#define QUERY_LENGTH 20
+
+static const char pickerChars[] = " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+static char query[QUERY_LENGTH+1] = "";
+static int picker = 1;
+
+static int* results = NULL;
+static int resultCount = 0;
+
+static void _setHeader(Menu* m)
+{
+	char header[32];
+	sprintf(header, "FIND: %s[%c]", query, pickerChars[picker]);
+	setMenuHeader(m, header);
+}
+
+static void _printHelp()
+{
+	clearScreen(&topScreen);
+
+	iprintf("Search ROM library\n\n");
+	iprintf("%d ROMs indexed\n\n", libraryCount());
+	iprintf("Pick letter - [L] [R]\n");
+	iprintf("Add letter  - [A]\n");
+	iprintf("Delete      - [B]\n");
+	iprintf("Install     - [START]\n");
+	iprintf("Rescan SD   - [SELECT]\n");
+}
+
+static void _printItem(Menu* m)
+{
+	if (m->itemCount <= 0)
+		_printHelp();
+	else
+		printRomInfo(m->items[m->cursor].value);
+}
+
+static void _generateList(Menu* m)
+{
+	clearMenu(m);
+
+	m->page += m->changePage;
+	m->changePage = 0;
+	m->itemTotal = resultCount;
+
+	for (int i = m->page * ITEMS_PER_PAGE; i < resultCount && m->itemCount < ITEMS_PER_PAGE; i++)
+	{
+		char const* path = libraryPath(results[i]);
+		char const* name = strrchr(path, '/');
+
+		addMenuItem(m, name ? name + 1 : path, path, 0);
+	}
+
+	m->nextPage = ((m->page + 1) * ITEMS_PER_PAGE < resultCount);
+
+	if (m->cursor >= m->itemCount)
+		m->cursor = m->itemCount - 1;
+
+	if (m->cursor < 0)
+		m->cursor = 0;
+}
+
+static void _search(Menu* m)
+{
+	resultCount = librarySearch(query, results, SEARCH_MAX_RESULTS);
+
+	_setHeader(m);
+	resetMenu(m);
+	_generateList(m);
+
+	printMenu(m);
+	_printItem(m);
+}
+
+static void _printScanProgress(int found)
+{
+	iprintf("\x1b[2;0H%d ROMs found", found);
+}
+
+static bool _rescan()
+{
+	clearScreen(&topScreen);
+	clearScreen(&bottomScreen);
+
+	iprintf("Scanning SD card for ROMs...\n");
+	swiWaitForVBlank();
+
+	if (libraryBuild(_printScanProgress) < 0)
+	{
+		messagePrint("\x1B[31m\nNot enough memory.\n\x1B[47m");
+		return false;
+	}
+
+	if (!librarySave())
+		messagePrint("\x1B[33m\nCould not save the library.\n\x1B[47m");
+
+	return true;
+}
+
+void searchMenu()
+{
+	if (!libraryLoad() && !_rescan())
+		return;
+
+	results = (int*)malloc(SEARCH_MAX_RESULTS * sizeof(int));
+	if (!results)
+	{
+		libraryFree();
+		return;
+	}
+
+	Menu* m = newMenu();
+	_search(m);
+
+	while (1)
+	{
+		swiWaitForVBlank();
+		scanKeys();
+
+		if (moveCursor(m))
+		{
+			if (m->changePage != 0)
+				_generateList(m);
+
+			printMenu(m);
+			_printItem(m);
+		}
+
+		if (keysDown() & (KEY_L | KEY_R))
+		{
+			const int count = sizeof(pickerChars) - 1;
+			picker = (picker + ((keysDown() & KEY_R) ? 1 : count - 1)) % count;
+
+			_setHeader(m);
+			printMenu(m);
+		}
+
+		else if (keysDown() & KEY_A)
+		{
+			int len = strlen(query);
+
+			if (len < QUERY_LENGTH)
+			{
+				query[len] = pickerChars[picker];
+				query[len+1] = '\0';
+				_search(m);
+			}
+		}
+
+		else if (keysDown() & KEY_B)
+		{
+			int len = strlen(query);
+
+			if (len <= 0)
+				break;
+
+			query[len-1] = '\0';
+			_search(m);
+		}
+
+		else if (keysDown() & KEY_START)
+		{
+			if (m->itemCount > 0)
+			{
+				installPrompt(m->items[m->cursor].value);
+				printMenu(m);
+				_printItem(m);
+			}
+		}
+
+		else if (keysDown() & KEY_SELECT)
+		{
+			_rescan();
+			_search(m);
+		}
+	}
+
+	freeMenu(m);
+
+	free(results);
+	results = NULL;
+	resultCount = 0;
+
+	libraryFree();
+}
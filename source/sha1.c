@@ -0,0 +1,197 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include <nds.h>
+
+#include "sha1.h"
+
+//the BIOS call is only there in DSi mode, and is slower than the unrolled rounds below
+static bool useBios = false;
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+//the message schedule is kept as a rolling 16 word window
+#define W0(i) (w[i] = ((u32)p[4*(i)] << 24) | ((u32)p[4*(i)+1] << 16) | ((u32)p[4*(i)+2] << 8) | p[4*(i)+3])
+#define W(i) (w[(i) & 15] = ROL(w[((i) + 13) & 15] ^ w[((i) + 8) & 15] ^ w[((i) + 2) & 15] ^ w[(i) & 15], 1))
+
+#define R0(a, b, c, d, e, i) e += ((b & (c ^ d)) ^ d) + W0(i) + 0x5A827999 + ROL(a, 5); b = ROL(b, 30);
+#define R1(a, b, c, d, e, i) e += ((b & (c ^ d)) ^ d) + W(i) + 0x5A827999 + ROL(a, 5); b = ROL(b, 30);
+#define R2(a, b, c, d, e, i) e += (b ^ c ^ d) + W(i) + 0x6ED9EBA1 + ROL(a, 5); b = ROL(b, 30);
+#define R3(a, b, c, d, e, i) e += (((b | c) & d) | (b & c)) + W(i) + 0x8F1BBCDC + ROL(a, 5); b = ROL(b, 30);
+#define R4(a, b, c, d, e, i) e += (b ^ c ^ d) + W(i) + 0xCA62C1D6 + ROL(a, 5); b = ROL(b, 30);
+
+//all 80 rounds written out with the variables rotating by name, runs from ITCM so the loop never waits on the bus
+ITCM_CODE static void _sha1Blocks(u32* state, u8 const* p, u32 blocks)
+{
+	u32 w[16];
+
+	while (blocks-- > 0)
+	{
+		u32 a = state[0];
+		u32 b = state[1];
+		u32 c = state[2];
+		u32 d = state[3];
+		u32 e = state[4];
+
+		R0(a,b,c,d,e, 0) R0(e,a,b,c,d, 1) R0(d,e,a,b,c, 2) R0(c,d,e,a,b, 3)
+		R0(b,c,d,e,a, 4) R0(a,b,c,d,e, 5) R0(e,a,b,c,d, 6) R0(d,e,a,b,c, 7)
+		R0(c,d,e,a,b, 8) R0(b,c,d,e,a, 9) R0(a,b,c,d,e,10) R0(e,a,b,c,d,11)
+		R0(d,e,a,b,c,12) R0(c,d,e,a,b,13) R0(b,c,d,e,a,14) R0(a,b,c,d,e,15)
+		R1(e,a,b,c,d,16) R1(d,e,a,b,c,17) R1(c,d,e,a,b,18) R1(b,c,d,e,a,19)
+
+		R2(a,b,c,d,e,20) R2(e,a,b,c,d,21) R2(d,e,a,b,c,22) R2(c,d,e,a,b,23)
+		R2(b,c,d,e,a,24) R2(a,b,c,d,e,25) R2(e,a,b,c,d,26) R2(d,e,a,b,c,27)
+		R2(c,d,e,a,b,28) R2(b,c,d,e,a,29) R2(a,b,c,d,e,30) R2(e,a,b,c,d,31)
+		R2(d,e,a,b,c,32) R2(c,d,e,a,b,33) R2(b,c,d,e,a,34) R2(a,b,c,d,e,35)
+		R2(e,a,b,c,d,36) R2(d,e,a,b,c,37) R2(c,d,e,a,b,38) R2(b,c,d,e,a,39)
+
+		R3(a,b,c,d,e,40) R3(e,a,b,c,d,41) R3(d,e,a,b,c,42) R3(c,d,e,a,b,43)
+		R3(b,c,d,e,a,44) R3(a,b,c,d,e,45) R3(e,a,b,c,d,46) R3(d,e,a,b,c,47)
+		R3(c,d,e,a,b,48) R3(b,c,d,e,a,49) R3(a,b,c,d,e,50) R3(e,a,b,c,d,51)
+		R3(d,e,a,b,c,52) R3(c,d,e,a,b,53) R3(b,c,d,e,a,54) R3(a,b,c,d,e,55)
+		R3(e,a,b,c,d,56) R3(d,e,a,b,c,57) R3(c,d,e,a,b,58) R3(b,c,d,e,a,59)
+
+		R4(a,b,c,d,e,60) R4(e,a,b,c,d,61) R4(d,e,a,b,c,62) R4(c,d,e,a,b,63)
+		R4(b,c,d,e,a,64) R4(a,b,c,d,e,65) R4(e,a,b,c,d,66) R4(d,e,a,b,c,67)
+		R4(c,d,e,a,b,68) R4(b,c,d,e,a,69) R4(a,b,c,d,e,70) R4(e,a,b,c,d,71)
+		R4(d,e,a,b,c,72) R4(c,d,e,a,b,73) R4(b,c,d,e,a,74) R4(a,b,c,d,e,75)
+		R4(e,a,b,c,d,76) R4(d,e,a,b,c,77) R4(c,d,e,a,b,78) R4(b,c,d,e,a,79)
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+
+		p += 64;
+	}
+}
+
+void sha1SetBios(bool enable)
+{
+	useBios = enable && isDSiMode();
+}
+
+bool sha1GetBios()
+{
+	return useBios;
+}
+
+void sha1Init(Sha1Context* ctx)
+{
+	ctx->bios = useBios;
+
+	if (ctx->bios)
+	{
+		swiSHA1Init(&ctx->biosContext);
+		return;
+	}
+
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xEFCDAB89;
+	ctx->state[2] = 0x98BADCFE;
+	ctx->state[3] = 0x10325476;
+	ctx->state[4] = 0xC3D2E1F0;
+	ctx->length = 0;
+}
+
+void sha1Update(Sha1Context* ctx, void const* data, u32 len)
+{
+	if (ctx->bios)
+	{
+		swiSHA1Update(&ctx->biosContext, data, len);
+		return;
+	}
+
+	u8 const* p = (u8 const*)data;
+	u32 used = ctx->length & 63;
+	ctx->length += len;
+
+	//top up a partial block first
+	if (used > 0)
+	{
+		u32 n = 64 - used;
+		if (n > len) n = len;
+
+		memcpy(ctx->block + used, p, n);
+		p += n;
+		len -= n;
+
+		if (used + n < 64)
+			return;
+
+		_sha1Blocks(ctx->state, ctx->block, 1);
+	}
+
+	//whole blocks straight from the caller's buffer
+	if (len >= 64)
+	{
+		_sha1Blocks(ctx->state, p, len / 64);
+		p += len & ~63;
+		len &= 63;
+	}
+
+	memcpy(ctx->block, p, len);
+}
+
+void sha1Final(u8* digest, Sha1Context* ctx)
+{
+	if (ctx->bios)
+	{
+		swiSHA1Final(digest, &ctx->biosContext);
+		return;
+	}
+
+	u64 bits = ctx->length * 8;
+	u32 used = ctx->length & 63;
+
+	ctx->block[used++] = 0x80;
+
+	if (used > 56)
+	{
+		memset(ctx->block + used, 0, 64 - used);
+		_sha1Blocks(ctx->state, ctx->block, 1);
+		used = 0;
+	}
+
+	memset(ctx->block + used, 0, 56 - used);
+
+	for (int i = 0; i < 8; i++)
+		ctx->block[63 - i] = bits >> (i * 8);
+
+	_sha1Blocks(ctx->state, ctx->block, 1);
+
+	for (int i = 0; i < 5; i++)
+	{
+		digest[i*4] = ctx->state[i] >> 24;
+		digest[i*4+1] = ctx->state[i] >> 16;
+		digest[i*4+2] = ctx->state[i] >> 8;
+		digest[i*4+3] = ctx->state[i];
+	}
+}
+
+void sha1Calc(u8* digest, void const* data, u32 len)
+{
+	Sha1Context ctx;
+	sha1Init(&ctx);
+	sha1Update(&ctx, data, len);
+	sha1Final(digest, &ctx);
+}
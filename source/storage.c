@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <errno.h>
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <nds.h>
 
@@ -29,6 +30,55 @@
 
 #define TITLE_LIMIT 39
 
+//installed size of one title, reused until its folders change
+typedef struct {
+	char name[16];	//title id low, as its folder is named
+	time_t mtime;
+	time_t contentMtime;
+	unsigned long long size;
+} TitleSize;
+
+static TitleSize* titleSizes = NULL;
+static int titleSizeCount = 0;
+
+//walk over the titles in one folder, one entry per step so it can be spread over frames
+typedef struct {
+	DIR* dir;
+	char path[32];
+	TitleSize* sizes;
+	int count;
+	int cap;
+	unsigned long long total;	//block rounded, so far
+} TitleScan;
+
+//the test menu's numbers, gathered in the background
+static StorageStats stats;
+static TitleScan statsScan;
+static bool statsScanning = false;
+
+//installed titles, sorted, read once and then kept current by the install and delete paths
+typedef struct {
+	u32 tidHigh;
+	u32 tidLow;
+} TitleId;
+
+#define TITLE_DIR_COUNT 4
+#define TITLE_SLOT_DIRS 3	//the first ones take a home menu slot
+
+static const u32 titleDirs[TITLE_DIR_COUNT] = {
+	0x00030004,
+	0x00030005,
+	0x00030015,
+	0x00030017
+};
+
+static TitleId* titles = NULL;
+static int titleCount = 0;
+static int titleCap = 0;
+static bool titlesLoaded = false;
+static time_t titleDirMtimes[TITLE_DIR_COUNT];
+static int otherDirCounts[TITLE_DIR_COUNT];	//folders that aren't named by a title id, they still take a slot
+
 //printing
 void printBytes(unsigned long long bytes)
 {
@@ -191,11 +241,10 @@ unsigned long long getFileSizePath(char const* path)
 {
 	if (!path) return 0;
 
-	FILE* f = fopen(path, "rb");
-	unsigned long long size = getFileSize(f);
-	fclose(f);
+	struct stat st;
+	if (stat(path, &st) != 0) return 0;
 
-	return size;
+	return st.st_size;
 }
 
 bool padFile(char const* path, int size)
@@ -273,6 +322,8 @@ bool deleteDir(char const* path)
 				sprintf(fpath, "%s/%s", path, ent->d_name);
 
 				iprintf("%s...", fpath);
+				unsigned long long size = getFileSizePath(fpath);
+
 				if (remove(fpath) != 0)
 				{
 					iprintf("\x1B[31m");
@@ -282,6 +333,7 @@ bool deleteDir(char const* path)
 				}
 				else
 				{
+					sdLedgerResize(size, 0);
 					iprintf("\x1B[42m");
 					iprintf("Done\n");
 					iprintf("\x1B[47m");
@@ -310,10 +362,14 @@ bool deleteDir(char const* path)
 	return result;
 }
 
-unsigned long long getDirSize(const char* path)
+//DSi storage is handed out per file in whole blocks
+static unsigned long long _roundBlock(unsigned long long size)
 {
-	if (!path) return 0;
+	return (size + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK * BYTES_PER_BLOCK;
+}
 
+static unsigned long long _dirSize(const char* path, bool blocks)
+{
 	unsigned long long size = 0;
 	DIR* dir = opendir(path);
 	struct dirent* ent;
@@ -325,19 +381,17 @@ unsigned long long getDirSize(const char* path)
 			if(strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
 				continue;
 
+			char fullpath[512];
+			sprintf(fullpath, "%s/%s", path, ent->d_name);
+
 			if (ent->d_type == DT_DIR)
 			{
-				char fullpath[512];
-				sprintf(fullpath, "%s/%s", path, ent->d_name);
-
-				size += getDirSize(fullpath);
+				size += _dirSize(fullpath, blocks);
 			}
 			else
-			{				
-				char fullpath[260];
-				sprintf(fullpath, "%s/%s", path, ent->d_name);				
-
-				size += getFileSizePath(fullpath);
+			{
+				unsigned long long fileSize = getFileSizePath(fullpath);
+				size += blocks ? _roundBlock(fileSize) : fileSize;
 			}
 		}
 	}
@@ -346,6 +400,280 @@ unsigned long long getDirSize(const char* path)
 	return size;
 }
 
+unsigned long long getDirSize(const char* path)
+{
+	if (!path) return 0;
+
+	return _dirSize(path, false);
+}
+
+static time_t _mtime(char const* path)
+{
+	struct stat st;
+	return (stat(path, &st) == 0) ? st.st_mtime : 0;
+}
+
+static bool _titleScanOpen(TitleScan* scan, char const* path)
+{
+	memset(scan, 0, sizeof(TitleScan));
+	snprintf(scan->path, sizeof(scan->path), "%s", path);
+
+	scan->dir = opendir(path);
+	return scan->dir != NULL;
+}
+
+static void _titleScanClose(TitleScan* scan)
+{
+	if (scan->dir)
+		closedir(scan->dir);
+
+	free(scan->sizes);
+	memset(scan, 0, sizeof(TitleScan));
+}
+
+//sizes one more entry, only titles whose folders changed are walked again
+//returns false once the folder is done, and the new sizes replace the cached ones
+static bool _titleScanStep(TitleScan* scan)
+{
+	if (!scan->dir) return false;
+
+	struct dirent* ent = readdir(scan->dir);
+
+	if (!ent)
+	{
+		closedir(scan->dir);
+		scan->dir = NULL;
+
+		free(titleSizes);
+		titleSizes = scan->sizes;
+		titleSizeCount = scan->count;
+		scan->sizes = NULL;
+
+		return false;
+	}
+
+	if(strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
+		return true;
+
+	char fullpath[512];
+	sprintf(fullpath, "%s/%s", scan->path, ent->d_name);
+
+	if (ent->d_type != DT_DIR)
+	{
+		scan->total += _roundBlock(getFileSizePath(fullpath));
+		return true;
+	}
+
+	if (scan->count >= scan->cap)
+	{
+		int cap = (scan->cap == 0) ? 64 : scan->cap * 2;
+		TitleSize* grown = (TitleSize*)realloc(scan->sizes, cap * sizeof(TitleSize));
+
+		if (!grown)
+		{
+			scan->total += _dirSize(fullpath, true);
+			return true;
+		}
+
+		scan->sizes = grown;
+		scan->cap = cap;
+	}
+
+	TitleSize* t = &scan->sizes[scan->count++];
+	snprintf(t->name, sizeof(t->name), "%s", ent->d_name);
+	t->mtime = _mtime(fullpath);
+
+	char contentPath[512];
+	sprintf(contentPath, "%s/content", fullpath);
+	t->contentMtime = _mtime(contentPath);
+
+	t->size = (unsigned long long)-1;
+
+	for (int i = 0; i < titleSizeCount; i++)
+	{
+		if (strcmp(titleSizes[i].name, t->name) == 0)
+		{
+			if (titleSizes[i].mtime == t->mtime && titleSizes[i].contentMtime == t->contentMtime)
+				t->size = titleSizes[i].size;
+
+			break;
+		}
+	}
+
+	if (t->size == (unsigned long long)-1)
+		t->size = _dirSize(fullpath, true);
+
+	scan->total += t->size;
+	return true;
+}
+
+//block rounded size of every title in path
+static unsigned long long _getTitlesSize(char const* path)
+{
+	TitleScan scan;
+
+	if (!_titleScanOpen(&scan, path))
+		return 0;
+
+	while (_titleScanStep(&scan));
+
+	unsigned long long total = scan.total;
+	_titleScanClose(&scan);
+
+	return total;
+}
+
+//FAT does not always touch a folder's time when the files in it change, so installs and deletes say so directly
+static void _forgetTitleSize(u32 tidLow)
+{
+	char name[16];
+	sprintf(name, "%08x", (unsigned int)tidLow);
+
+	for (int i = 0; i < titleSizeCount; i++)
+	{
+		if (strcmp(titleSizes[i].name, name) == 0)
+		{
+			titleSizes[i] = titleSizes[--titleSizeCount];
+			break;
+		}
+	}
+}
+
+//installed titles
+//first entry not below tidHigh:tidLow
+static int _findTitle(u32 tidHigh, u32 tidLow)
+{
+	int lo = 0;
+	int hi = titleCount;
+
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+
+		if (titles[mid].tidHigh < tidHigh || (titles[mid].tidHigh == tidHigh && titles[mid].tidLow < tidLow))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static bool _insertTitle(u32 tidHigh, u32 tidLow)
+{
+	int i = _findTitle(tidHigh, tidLow);
+
+	if (i < titleCount && titles[i].tidHigh == tidHigh && titles[i].tidLow == tidLow)
+		return true;
+
+	if (titleCount >= titleCap)
+	{
+		int cap = (titleCap == 0) ? 64 : titleCap * 2;
+		TitleId* grown = (TitleId*)realloc(titles, cap * sizeof(TitleId));
+		if (!grown) return false;
+
+		titles = grown;
+		titleCap = cap;
+	}
+
+	memmove(&titles[i+1], &titles[i], (titleCount - i) * sizeof(TitleId));
+	titles[i].tidHigh = tidHigh;
+	titles[i].tidLow = tidLow;
+	titleCount++;
+
+	return true;
+}
+
+//one scan of the title folders, done again only when one of their times moves
+static void _loadTitles()
+{
+	time_t mtimes[TITLE_DIR_COUNT];
+	bool changed = !titlesLoaded;
+
+	for (int i = 0; i < TITLE_DIR_COUNT; i++)
+	{
+		char path[32];
+		sprintf(path, "/title/%08x", (unsigned int)titleDirs[i]);
+
+		mtimes[i] = _mtime(path);
+
+		if (mtimes[i] != titleDirMtimes[i])
+			changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	titleCount = 0;
+
+	for (int i = 0; i < TITLE_DIR_COUNT; i++)
+	{
+		char path[32];
+		sprintf(path, "/title/%08x", (unsigned int)titleDirs[i]);
+
+		titleDirMtimes[i] = mtimes[i];
+		otherDirCounts[i] = 0;
+
+		DIR* dir = opendir(path);
+		if (!dir) continue;
+
+		struct dirent* ent;
+
+		while ( (ent = readdir(dir)) != NULL )
+		{
+			if(strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
+				continue;
+
+			if (ent->d_type != DT_DIR)
+				continue;
+
+			//strtoul would make every other name title 0
+			if (strlen(ent->d_name) == 8 && strspn(ent->d_name, "0123456789abcdefABCDEF") == 8)
+				_insertTitle(titleDirs[i], strtoul(ent->d_name, NULL, 16));
+			else
+				otherDirCounts[i]++;
+		}
+
+		closedir(dir);
+	}
+
+	titlesLoaded = true;
+}
+
+//checks the table only, getMenuSlotsFree() is what rescans after outside changes
+bool titleExists(u32 tidHigh, u32 tidLow)
+{
+	if (!titlesLoaded)
+		_loadTitles();
+
+	int i = _findTitle(tidHigh, tidLow);
+
+	return (i < titleCount && titles[i].tidHigh == tidHigh && titles[i].tidLow == tidLow);
+}
+
+void titleAdded(u32 tidHigh, u32 tidLow)
+{
+	if (titlesLoaded)
+		_insertTitle(tidHigh, tidLow);
+
+	_forgetTitleSize(tidLow);
+	storageStatsInvalidate();
+}
+
+void titleRemoved(u32 tidHigh, u32 tidLow)
+{
+	int i = _findTitle(tidHigh, tidLow);
+
+	if (i < titleCount && titles[i].tidHigh == tidHigh && titles[i].tidLow == tidLow)
+	{
+		memmove(&titles[i], &titles[i+1], (titleCount - i - 1) * sizeof(TitleId));
+		titleCount--;
+	}
+
+	_forgetTitleSize(tidLow);
+	storageStatsInvalidate();
+}
+
 //home menu
 int getMenuSlots()
 {
@@ -357,41 +685,22 @@ int getMenuSlots()
 int getMenuSlotsFree()
 {
 	//Get number of open menu slots by subtracting the number of directories in the title folders
-	//Find a better way to do this
-	const int NUM_OF_DIRS = 3;
-	const char* dirs[] = {
-		"00030004",
-		"00030005",
-		"00030015"
-	};
+	_loadTitles();
 
 	int freeSlots = getMenuSlots();
-	
-	DIR* dir;
-	struct dirent* ent;	
-	
-	for (int i = 0; i < NUM_OF_DIRS; i++)
+
+	for (int j = 0; j < TITLE_SLOT_DIRS; j++)
+		freeSlots -= otherDirCounts[j];
+
+	for (int i = 0; i < titleCount; i++)
 	{
-		char path[256];
-		sprintf(path, "/title/%s", dirs[i]);
-		
-		dir = opendir(path);
-		
-		if (dir)
+		for (int j = 0; j < TITLE_SLOT_DIRS; j++)
 		{
-			while ( (ent = readdir(dir)) != NULL )
-			{
-				if(strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
-					continue;
-				
-				if (ent->d_type == DT_DIR)
-					freeSlots -= 1;
-			}			
+			if (titles[i].tidHigh == titleDirs[j])
+				freeSlots -= 1;
 		}
-
-		closedir(dir);
 	}
-	
+
 	return freeSlots;
 }
 
@@ -426,6 +735,81 @@ unsigned long long getSDCardFree()
 	return 0;
 }
 
+//space ledger, one statvfs and then installs and the app's own files take their share of it in memory
+static bool ledgerValid = false;
+static unsigned long long ledgerFree = 0;
+static unsigned long long ledgerCluster = 0;
+
+static bool _ledgerLoad()
+{
+	if (ledgerValid)
+		return true;
+
+	struct statvfs st;
+
+	if (!sdIsInserted() || statvfs("/", &st) != 0)
+		return false;
+
+	ledgerFree = (unsigned long long)st.f_bsize * st.f_bavail;
+	ledgerCluster = (st.f_bsize > 0) ? st.f_bsize : 512;
+	ledgerValid = true;
+
+	return true;
+}
+
+//files take whole clusters
+unsigned long long sdRoundCluster(unsigned long long size)
+{
+	if (!_ledgerLoad())
+		return size;
+
+	return (size + ledgerCluster - 1) / ledgerCluster * ledgerCluster;
+}
+
+unsigned long long sdLedgerFree()
+{
+	return _ledgerLoad() ? ledgerFree : 0;
+}
+
+//takes room for every file in sizes, all or nothing
+bool sdReserve(unsigned long long const* sizes, int count)
+{
+	if (!_ledgerLoad())
+		return false;
+
+	unsigned long long total = 0;
+
+	for (int i = 0; i < count; i++)
+		total += sdRoundCluster(sizes[i]);
+
+	//the ledger only ever counts less free space than there is, so look again before saying no
+	if (total > ledgerFree)
+	{
+		ledgerValid = false;
+
+		if (!_ledgerLoad() || total > ledgerFree)
+			return false;
+	}
+
+	ledgerFree -= total;
+	return true;
+}
+
+//a file the app wrote, removed or rewrote went from oldSize to newSize bytes, 0 when there is none
+void sdLedgerResize(unsigned long long oldSize, unsigned long long newSize)
+{
+	if (!ledgerValid)
+		return;
+
+	unsigned long long before = sdRoundCluster(oldSize);
+	unsigned long long after = sdRoundCluster(newSize);
+
+	if (after > before)
+		ledgerFree = (after - before < ledgerFree) ? ledgerFree - (after - before) : 0;
+	else
+		ledgerFree += before - after;
+}
+
 //internal storage
 unsigned long long getDsiSize()
 {
@@ -434,25 +818,98 @@ unsigned long long getDsiSize()
 	return 1024 * BYTES_PER_BLOCK;
 }
 
-unsigned long long getDsiFree()
+//what is left once appSize is taken, but don't go under 0
+static unsigned long long _dsiFree(unsigned long long appSize)
 {
-	//Get free space by subtracting file sizes in emulated nand folders
 	unsigned long long size = getDsiSize();
-	unsigned long long appSize = getDirSize("/title/00030004");
-
-	//round up to a full block
-	if (appSize % BYTES_PER_BLOCK != 0)
-		appSize = ((int)(appSize / BYTES_PER_BLOCK) * BYTES_PER_BLOCK) + BYTES_PER_BLOCK;
 
-	//subtract, but don't go under 0
 	if (appSize > size)
+		return 0;
+
+	return size - appSize;
+}
+
+unsigned long long getDsiFree()
+{
+	//Get free space by subtracting block rounded file sizes in emulated nand folders
+	return _dsiFree(_getTitlesSize("/title/00030004"));
+}
+
+//storage stats
+//installs and deletes call this, the next steps start over
+void storageStatsInvalidate()
+{
+	_titleScanClose(&statsScan);
+	statsScanning = false;
+	memset(&stats, 0, sizeof(stats));
+}
+
+//does what fits in ticks, returns true while anything is left
+bool storageStatsStep(u32 ticks)
+{
+	if (stats.ready[STORAGE_STAT_DSI])
+		return false;
+
+	//restarts the one timer libnds times with, this can't run inside another timed span
+	cpuStartTiming(0);
+
+	do
 	{
-		size = 0;
-	}
-	else
-	{
-		size -= appSize;
+		if (!stats.ready[STORAGE_STAT_SLOTS])
+		{
+			if (isDSiMode())
+				stats.slotsFree = getMenuSlotsFree();
+
+			stats.ready[STORAGE_STAT_SLOTS] = true;
+		}
+		else if (!stats.ready[STORAGE_STAT_SD])
+		{
+			//one statvfs for both numbers
+			struct statvfs st;
+
+			if (sdIsInserted() && statvfs("/", &st) == 0)
+			{
+				stats.sdFree = (unsigned long long)st.f_bsize * st.f_bavail;
+				stats.sdSize = (unsigned long long)st.f_bsize * st.f_blocks;
+			}
+
+			stats.ready[STORAGE_STAT_SD] = true;
+		}
+		else
+		{
+			//a title per step
+			if (!isDSiMode())
+			{
+				stats.ready[STORAGE_STAT_DSI] = true;
+			}
+			else if (!statsScanning)
+			{
+				statsScanning = _titleScanOpen(&statsScan, "/title/00030004");
+
+				if (!statsScanning)
+				{
+					stats.dsiFree = getDsiSize();
+					stats.ready[STORAGE_STAT_DSI] = true;
+				}
+			}
+			else if (!_titleScanStep(&statsScan))
+			{
+				stats.dsiFree = _dsiFree(statsScan.total);
+				stats.ready[STORAGE_STAT_DSI] = true;
+				_titleScanClose(&statsScan);
+				statsScanning = false;
+			}
+		}
 	}
+	while (!stats.ready[STORAGE_STAT_DSI] && (ticks == 0 || cpuGetTiming() < ticks));
 
-	return size;
-}
\ No newline at end of file
+	cpuEndTiming();
+
+	return !stats.ready[STORAGE_STAT_DSI];
+}
+
+//check ready[] before using a number
+StorageStats const* getStorageStats()
+{
+	return &stats;
+}
@@ -18,77 +18,404 @@
 */
 
 #include <stdio.h>
+#include <dirent.h>
 
 #include <nds.h>
 
 #include "main.h"
+#include "crc16.h"
+#include "maketmd.h"
+#include "nitrofs.h"
 #include "message.h"
+#include "sha1.h"
 #include "storage.h"
 
-void testMenu()
+//cpuGetTiming() counts at the bus clock
+#define TICKS_PER_MS (BUS_CLOCK / 1000)
+
+//read size for the nitrofs benchmark, what a stdio reader would typically ask for
+#define BENCH_BUFFER 0x200
+
+//time each frame may spend on storage stats that are not ready yet, in cpuGetTiming() ticks
+#define STATS_STEP_TICKS (BUS_CLOCK / 100)
+
+//data hashed by the hashing benchmark, about a template's worth
+#define HASH_BENCH_SIZE 0x40000
+
+typedef struct {
+	int files;
+	int dirs;
+	unsigned long long bytes;
+} BenchCount;
+
+//lists, opens and reads every file below path
+static void _benchDir(char const* path, u8* buffer, BenchCount* count)
+{
+	DIR* dir = opendir(path);
+	if (!dir) return;
+
+	struct dirent* ent;
+
+	while ( (ent = readdir(dir)) )
+	{
+		if (strcmp(".", ent->d_name) == 0 || strcmp("..", ent->d_name) == 0)
+			continue;
+
+		char* fpath = (char*)malloc(strlen(path) + strlen(ent->d_name) + 8);
+		sprintf(fpath, "%s/%s", path, ent->d_name);
+
+		if (ent->d_type == DT_DIR)
+		{
+			count->dirs++;
+			_benchDir(fpath, buffer, count);
+		}
+		else
+		{
+			FILE* f = fopen(fpath, "rb");
+
+			if (f)
+			{
+				size_t bytesRead;
+				while ( (bytesRead = fread(buffer, 1, BENCH_BUFFER, f)) > 0 )
+					count->bytes += bytesRead;
+
+				fclose(f);
+				count->files++;
+			}
+		}
+
+		free(fpath);
+	}
+
+	closedir(dir);
+}
+
+//times a full walk of nitro: and shows what it cost in card access
+static void _benchNitroFS()
 {
-	//top screen
 	clearScreen(&topScreen);
-	iprintf("Storage Check Test\n\n");
+	iprintf("NitroFS Benchmark\n\n");
+
+	if (!mountNitroFS())
+		return;
+
+	u8* buffer = (u8*)malloc(BENCH_BUFFER);
+	if (!buffer) return;
+
+	BenchCount count = { 0 };
+	struct nitroCacheStats stats;
+
+	nitroFSResetCacheStats();
+	cpuStartTiming(2);
+
+	_benchDir("nitro:", buffer, &count);
+
+	u32 ticks = cpuEndTiming();
+	nitroFSGetCacheStats(&stats);
+	free(buffer);
+
+	iprintf("%d files, %d folders\n", count.files, count.dirs);
+	printBytes(count.bytes);
+	iprintf(" read in %u ms\n\n", (unsigned int)(ticks / TICKS_PER_MS));
+
+	iprintf("Card access:\n");
+	iprintf("\t%u fseeks\n", (unsigned int)stats.deviceSeeks);
+	iprintf("\t%u freads, ", (unsigned int)stats.deviceReads);
+	printBytes(stats.deviceBytes);
+	iprintf("\n");
+	iprintf("\t%u hits / %u misses\n", (unsigned int)stats.hits, (unsigned int)stats.misses);
+
+	if (stats.resident > 0)
+	{
+		iprintf("\tResident: ");
+		printBytes(stats.resident);
+		iprintf("\n");
+	}
+}
+
+//times our sha1 and crc16 against the BIOS ones on the same data, and keeps the faster sha1
+static void _benchHashing()
+{
+	clearScreen(&topScreen);
+	iprintf("Hashing Benchmark\n\n");
+
+	u8* buffer = (u8*)malloc(HASH_BENCH_SIZE);
+	if (!buffer) return;
+
+	for (int i = 0; i < HASH_BENCH_SIZE; i++)
+		buffer[i] = i * 7 + (i >> 8);
+
+	u8 digest[2][SHA1_DIGEST_LENGTH];
+	u32 ticks[2];
+
+	for (int bios = 0; bios < 2; bios++)
+	{
+		sha1SetBios(bios);
+
+		cpuStartTiming(2);
+		sha1Calc(digest[bios], buffer, HASH_BENCH_SIZE);
+		ticks[bios] = cpuEndTiming();
+	}
+
+	u16 crc[2];
+	u32 crcTicks[2];
+
+	cpuStartTiming(2);
+	crc[0] = crc16(0xFFFF, buffer, HASH_BENCH_SIZE);
+	crcTicks[0] = cpuEndTiming();
+
+	cpuStartTiming(2);
+	crc[1] = swiCRC16(0xFFFF, buffer, HASH_BENCH_SIZE);
+	crcTicks[1] = cpuEndTiming();
+
+	free(buffer);
+
+	printBytes(HASH_BENCH_SIZE);
+	iprintf(" CRC16 in:\n");
+	iprintf("\tcrc16.c %5u ms\n", (unsigned int)(crcTicks[0] / TICKS_PER_MS));
+	iprintf("\tBIOS    %5u ms\n", (unsigned int)(crcTicks[1] / TICKS_PER_MS));
+
+	if (crc[0] != crc[1])
+	{
+		iprintf("\x1B[31m");	//red
+		iprintf("CRCs differ!\n");
+		iprintf("\x1B[47m");	//white
+	}
+
+	iprintf("\n");
+
+	printBytes(HASH_BENCH_SIZE);
+	iprintf(" SHA-1 in:\n");
+	iprintf("\tsha1.c  %5u ms\n", (unsigned int)(ticks[0] / TICKS_PER_MS));
+	iprintf("\tBIOS    %5u ms\n\n", (unsigned int)(ticks[1] / TICKS_PER_MS));
+
+	if (memcmp(digest[0], digest[1], SHA1_DIGEST_LENGTH) != 0)
+	{
+		iprintf("\x1B[31m");	//red
+		iprintf("Digests differ, using BIOS.\n");
+		iprintf("\x1B[47m");	//white
+		sha1SetBios(true);
+		return;
+	}
+
+	sha1SetBios(ticks[1] < ticks[0]);
+	iprintf("Digests match, using %s.\n", sha1GetBios() ? "BIOS" : "sha1.c");
+}
+
+//checks every installed title's TMD against its app and rewrites the ones that are off
+static void _verifyTmds()
+{
+	const int NUM_OF_DIRS = 3;
+	const char* dirs[] = {
+		"00030004",
+		"00030005",
+		"00030015"
+	};
+
+	clearScreen(&topScreen);
+	iprintf("TMD Check\n\n");
+
+	int checked = 0;
+	int repaired = 0;
+	int bad = 0;
 
-	//bottom screen
+	for (int i = 0; i < NUM_OF_DIRS; i++)
+	{
+		char path[80];
+		sprintf(path, "/title/%s", dirs[i]);
+
+		DIR* dir = opendir(path);
+		if (!dir) continue;
+
+		struct dirent* ent;
+
+		while ( (ent = readdir(dir)) )
+		{
+			if (ent->d_type != DT_DIR || strlen(ent->d_name) != 8)
+				continue;
+
+			char contentPath[80];
+			sprintf(contentPath, "/title/%s/%s/content", dirs[i], ent->d_name);
+
+			iprintf("%s/%s ", dirs[i], ent->d_name);
+			swiWaitForVBlank();
+
+			checked++;
+
+			switch (tmdVerify(contentPath, true))
+			{
+				case TMD_VERIFY_OK:
+					iprintf("OK\n");
+					break;
+
+				case TMD_VERIFY_REPAIRED:
+					repaired++;
+					iprintf("\x1B[42m");	//green
+					iprintf("Fixed\n");
+					iprintf("\x1B[47m");	//white
+					break;
+
+				case TMD_VERIFY_MISMATCH:
+					bad++;
+					iprintf("\x1B[31m");	//red
+					iprintf("Bad\n");
+					iprintf("\x1B[47m");	//white
+					break;
+
+				default:
+					bad++;
+					iprintf("\x1B[33m");	//yellow
+					iprintf("No app\n");
+					iprintf("\x1B[47m");	//white
+					break;
+			}
+		}
+
+		closedir(dir);
+	}
+
+	iprintf("\n%d checked, %d fixed, %d bad\n", checked, repaired, bad);
+}
+
+//bottom screen, numbers still being worked out show as ...
+static void _printStorage(bool sdFound)
+{
 	clearScreen(&bottomScreen);
 
-	unsigned int free = 0;
-	unsigned int size = 0;
-	const bool sdFound = (access("sd:/", F_OK) == 0);
+	StorageStats const* storage = getStorageStats();
 
 	//home menu slots
 	if (isDSiMode() && sdFound) {
 		iprintf("Free Home Menu Slots:\n");
-		swiWaitForVBlank();
-
-		free = getMenuSlotsFree();
-		iprintf("\t%d / ", free);
-		swiWaitForVBlank();
 
-		size = getMenuSlots();
-		iprintf("%d\n", size);
-		swiWaitForVBlank();
+		if (storage->ready[STORAGE_STAT_SLOTS])
+			iprintf("\t%d / %d\n", storage->slotsFree, getMenuSlots());
+		else
+			iprintf("\t...\n");
 	}
 
 	//SD Card
 	{
 		iprintf("\nFree SD Space:\n\t");
-		swiWaitForVBlank();
 
-		unsigned long long sdfree = getSDCardFree();
-		printBytes(sdfree);
-		iprintf(" / ");
-		swiWaitForVBlank();
+		if (storage->ready[STORAGE_STAT_SD])
+		{
+			printBytes(storage->sdFree);
+			iprintf(" / ");
+			printBytes(storage->sdSize);
+			iprintf("\n");
 
-		unsigned long long sdsize = getSDCardSize();
-		printBytes(sdsize);	
-		iprintf("\n");
-		swiWaitForVBlank();
-
-		printf("\t%d / %d blocks\n", (unsigned int)(sdfree / BYTES_PER_BLOCK), (unsigned int)(sdsize / BYTES_PER_BLOCK));
+			printf("\t%d / %d blocks\n", (unsigned int)(storage->sdFree / BYTES_PER_BLOCK), (unsigned int)(storage->sdSize / BYTES_PER_BLOCK));
+		}
+		else
+		{
+			iprintf("...\n");
+		}
 	}
 
 	//Emunand
 	if (isDSiMode() && sdFound) {
 		iprintf("\nFree DSi Space:\n\t");
-		swiWaitForVBlank();
 
-		free = getDsiFree();
-		printBytes(free);
-		iprintf(" / ");
-		swiWaitForVBlank();
+		if (storage->ready[STORAGE_STAT_DSI])
+		{
+			unsigned int free = storage->dsiFree;
+			unsigned int size = getDsiSize();
+
+			printBytes(free);
+			iprintf(" / ");
+			printBytes(size);
+			iprintf("\n");
+
+			printf("\t%.0f / %.0f blocks\n", (float)free / BYTES_PER_BLOCK, (float)size / BYTES_PER_BLOCK);
+		}
+		else
+		{
+			iprintf("...\n");
+		}
+	}
 
-		size = getDsiSize();
-		printBytes(size);
+	//nitrofs block cache, for tuning nitroFSSetCache()
+	{
+		struct nitroCacheStats stats;
+		nitroFSGetCacheStats(&stats);
+
+		iprintf("\nNitroFS Cache:\n");
+		iprintf("\t%u hits / %u misses\n", (unsigned int)stats.hits, (unsigned int)stats.misses);
+		iprintf("\t%u reads, ", (unsigned int)stats.deviceReads);
+		printBytes(stats.deviceBytes);
 		iprintf("\n");
-		swiWaitForVBlank();
 
-		printf("\t%.0f / %.0f blocks\n", (float)free / BYTES_PER_BLOCK, (float)size / BYTES_PER_BLOCK);
+		if (stats.resident > 0)
+		{
+			iprintf("\tResident: ");
+			printBytes(stats.resident);
+			iprintf("\n");
+		}
 	}
 
 	//end
-	iprintf("\nBack - [B]\n");
-	keyWait(KEY_B);
+	iprintf("\nBenchmark NitroFS - [Y]\n");
+
+	if (isDSiMode() && sdFound)
+		iprintf("Verify TMDs - [X]\n");
+
+	if (isDSiMode())
+		iprintf("Benchmark hashing - [A]\n");
+
+	iprintf("Back - [B]\n");
+}
+
+void testMenu()
+{
+	//top screen
+	clearScreen(&topScreen);
+	iprintf("Storage Check Test\n\n");
+
+	//startup timeline
+	{
+		iprintf("Startup:\n");
+		iprintf("\tScreens    %5u ms\n", (unsigned int)(startupTicks[STARTUP_SCREENS] / TICKS_PER_MS));
+		iprintf("\tSD card    %5u ms\n", (unsigned int)(startupTicks[STARTUP_FAT] / TICKS_PER_MS));
+		iprintf("\tFirst menu %5u ms\n", (unsigned int)(startupTicks[STARTUP_MENU] / TICKS_PER_MS));
+
+		if (startupTicks[STARTUP_NITRO] > 0)
+			iprintf("\tNitroFS    %5u ms\n", (unsigned int)(startupTicks[STARTUP_NITRO] / TICKS_PER_MS));
+		else
+			iprintf("\tNitroFS    not mounted\n");
+	}
+
+	//bottom screen, filled in as the background stats finish
+	const bool sdFound = (access("sd:/", F_OK) == 0);
+	bool shown[STORAGE_STAT_COUNT];
+
+	memcpy(shown, getStorageStats()->ready, sizeof(shown));
+	_printStorage(sdFound);
+
+	while (1)
+	{
+		swiWaitForVBlank();
+
+		storageStatsStep(STATS_STEP_TICKS);
+
+		if (memcmp(shown, getStorageStats()->ready, sizeof(shown)) != 0)
+		{
+			memcpy(shown, getStorageStats()->ready, sizeof(shown));
+			_printStorage(sdFound);
+		}
+
+		scanKeys();
+
+		if (keysDown() & KEY_B)
+			break;
+
+		else if (keysDown() & KEY_Y)
+			_benchNitroFS();
+
+		else if ((keysDown() & KEY_X) && isDSiMode() && sdFound)
+			_verifyTmds();
+
+		else if ((keysDown() & KEY_A) && isDSiMode())
+			_benchHashing();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	bench_crc16 - times crc16() in source/crc16.c against the bitwise CRC
+
+	usage: bench_crc16
+
+	Runs crc16() and the one bit at a time CRC that host/libnds.c gives swiCRC16() over the
+	sizes install.c hashes, the NDS header and the largest banner, and over 64 KiB and 1 MiB,
+	each over and over for about BENCH_TIME ms. Reports MB/s for both and how many times
+	faster crc16() is. On the DS the BIOS call is the bitwise side.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nds.h>
+
+#include "crc16.h"
+
+//how long each size is run for, per kernel
+#define BENCH_TIME 250.0
+
+typedef u16 (*CrcFunc)(u16 crc, void const* data, u32 len);
+
+static double _milliseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//MB/s of func over size bytes, the last CRC in crc
+static double _bench(CrcFunc func, u8 const* data, u32 size, u16* crc)
+{
+	u64 bytes = 0;
+	double start = _milliseconds();
+	double elapsed = 0;
+
+	do
+	{
+		*crc = func(0xFFFF, data, size);
+		bytes += size;
+		elapsed = _milliseconds() - start;
+	}
+	while (elapsed < BENCH_TIME);
+
+	return bytes / (elapsed / 1000.0) / (1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[])
+{
+	u32 const sizes[] = { 0x15E, 0x23C0, 0x10000, 0x100000 };
+	u32 const largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+	u8* data = (u8*)malloc(largest);
+	if (!data)
+	{
+		printf("out of memory\n");
+		return 1;
+	}
+
+	u32 seed = 9;
+	for (u32 i = 0; i < largest; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+
+	bool same = true;
+
+	printf("bench_crc16: crc16() against the bitwise CRC\n");
+	printf("  %-16s %12s %12s %8s\n", "size", "crc16", "bitwise", "speedup");
+
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		u16 fast = 0;
+		u16 slow = 0;
+		double fastRate = _bench(crc16, data, sizes[i], &fast);
+		double slowRate = _bench(swiCRC16, data, sizes[i], &slow);
+
+		//the CRCs are compared so neither can be left out
+		same = same && fast == slow;
+
+		char what[32];
+		sprintf(what, "%u bytes", sizes[i]);
+		printf("  %-16s %7.1f MB/s %7.1f MB/s %7.1fx\n", what, fastRate, slowRate, fastRate / slowRate);
+	}
+
+	free(data);
+
+	if (!same)
+	{
+		printf("crc16() and the bitwise CRC disagree\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,212 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	bench_library - times the ROM library index in source/library.c on a generated SD tree
+
+	usage: bench_library [roms]
+
+	Writes a tree of small .nds files with headers and banner titles under build/library
+	(4000 ROMs unless given, plus a title/ folder the scan has to skip), then times
+	libraryBuild() over it, librarySave() and libraryLoad(), and librarySearch() for queries
+	typed a letter at a time the way the search menu sends them, and for cold multi word ones.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <nds.h>
+
+#include "library.h"
+#include "rom.h"
+
+#define TREE_ROOT "build/library"	//LIBRARY_ROOT for this program, see the Makefile
+#define TREE_DIRS 40
+#define MAX_RESULTS 64
+
+static const char* words[] = {
+	"Mario", "Kart", "Zelda", "Metroid", "Pokemon", "Tetris", "Puzzle", "Quest",
+	"Dragon", "Star", "Racing", "Party", "Brain", "Age", "Castle", "Kirby",
+	"Sonic", "Rhythm", "Heaven", "Picross", "Layton", "Advance", "Wars", "Golden"
+};
+
+#define WORD_COUNT (sizeof(words) / sizeof(words[0]))
+
+static double _milliseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//a header and a banner with the same title in every language, enough for library.c
+static bool _writeRom(char const* path, char const* title, int i)
+{
+	static u8 rom[0x200 + sizeof(sNDSBannerExt)];
+	memset(rom, 0, sizeof(rom));
+
+	tNDSHeader* h = (tNDSHeader*)rom;
+	sprintf(h->gameCode, "%c%c%cE", 'A' + i % 26, 'A' + i / 26 % 26, 'A' + i / 676 % 26);
+	h->bannerOffset = 0x200;
+
+	sNDSBannerExt* banner = (sNDSBannerExt*)(rom + 0x200);
+	banner->version = NDS_BANNER_VER_ZH_KO;
+
+	for (int lang = 0; lang < 8; lang++)
+	{
+		for (int c = 0; title[c] && c < 127; c++)
+			banner->titles[lang][c] = title[c];
+	}
+
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+
+	bool result = fwrite(rom, 1, 0x200 + NDS_BANNER_SIZE_ZH_KO, f) == 0x200 + NDS_BANNER_SIZE_ZH_KO;
+	fclose(f);
+	return result;
+}
+
+static bool _writeTree(int count)
+{
+	char path[256];
+	char title[128];
+
+	mkdir("build", 0777);
+	mkdir(TREE_ROOT, 0777);
+	mkdir(TREE_ROOT "/roms", 0777);
+	mkdir(TREE_ROOT "/title", 0777);
+
+	for (int d = 0; d < TREE_DIRS; d++)
+	{
+		sprintf(path, TREE_ROOT "/roms/%s %02d", words[d % WORD_COUNT], d);
+		mkdir(path, 0777);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		u32 a = i % WORD_COUNT;
+		u32 b = (i / WORD_COUNT + a * 7) % WORD_COUNT;
+		u32 c = (i * 13 + 5) % WORD_COUNT;
+
+		sprintf(title, "%s %s %s %d\nNintendo", words[a], words[b], words[c], i);
+		sprintf(path, TREE_ROOT "/roms/%s %02d/%s %s %d.nds", words[(i % TREE_DIRS) % WORD_COUNT], i % TREE_DIRS,
+				words[b], words[c], i);
+
+		if (!_writeRom(path, title, i))
+			return false;
+	}
+
+	//installed titles, never listed
+	sprintf(path, TREE_ROOT "/title/hidden.nds");
+	return _writeRom(path, "Hidden", 0);
+}
+
+//times query typed one letter at a time, each search narrowing the last one's range
+static void _benchTyping(char const* query)
+{
+	int results[MAX_RESULTS];
+	char typed[64];
+	int count = 0;
+	int len = strlen(query);
+
+	double start = _milliseconds();
+
+	for (int i = 1; i <= len; i++)
+	{
+		sprintf(typed, "%.*s", i, query);
+		count = librarySearch(typed, results, MAX_RESULTS);
+	}
+
+	double elapsed = _milliseconds() - start;
+
+	printf("  typed %-20s %8.2f us per search, %3d results, %d searches\n", query, elapsed * 1000 / len, count, len);
+}
+
+static void _benchQuery(char const* query, int repeat)
+{
+	int results[MAX_RESULTS];
+	int count = 0;
+
+	double start = _milliseconds();
+
+	for (int i = 0; i < repeat; i++)
+	{
+		librarySearch("", results, MAX_RESULTS);	//forget the last range
+		count = librarySearch(query, results, MAX_RESULTS);
+	}
+
+	double elapsed = _milliseconds() - start;
+
+	printf("  cold  %-20s %8.2f us per search, %3d results\n", query, elapsed * 1000 / repeat, count);
+}
+
+int main(int argc, char* argv[])
+{
+	int count = (argc > 1) ? atoi(argv[1]) : 4000;
+
+	if (count <= 0)
+	{
+		printf("usage: %s [roms]\n", argv[0]);
+		return 1;
+	}
+
+	if (!_writeTree(count))
+	{
+		printf("can't write %s\n", TREE_ROOT);
+		return 1;
+	}
+
+	double start = _milliseconds();
+	int found = libraryBuild(NULL);
+	double built = _milliseconds();
+
+	printf("%s: %d ROMs\n", TREE_ROOT, found);
+	printf("  build          %8.2f ms\n", built - start);
+
+	if (found != count)
+		printf("  expected %d, the scan missed or kept ROMs it shouldn't\n", count);
+
+	start = _milliseconds();
+	bool saved = librarySave();
+	double saveTime = _milliseconds() - start;
+
+	start = _milliseconds();
+	bool loaded = saved && libraryLoad();
+	double loadTime = _milliseconds() - start;
+
+	printf("  save           %8.2f ms%s\n", saveTime, saved ? "" : " failed");
+	printf("  load           %8.2f ms%s\n", loadTime, loaded ? "" : " failed");
+
+	_benchTyping("zelda");
+	_benchTyping("pokemon star");
+	_benchTyping("rhythm heaven");
+	_benchTyping("kart 1234");
+
+	_benchQuery("m", 100);
+	_benchQuery("brain age", 100);
+	_benchQuery("aaae", 100);
+	_benchQuery("castle quest golden", 100);
+	_benchQuery("nothing", 100);
+
+	libraryFree();
+	return (found == count && loaded) ? 0 : 1;
+}
@@ -0,0 +1,410 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	bench_nitrofs - times source/nitrofs.c on .nds images, the templates in nitro/ or any ROM
+
+	usage: bench_nitrofs [image.nds ...]
+
+	Finds every file in each image, then looks each one up twice: once the way nitrofs did
+	before the v0.12 index, walking the FNT on the unbuffered image entry by entry with a FAT
+	read for every file passed, and once through nitroFSOpen() on the index. After that the
+	image is mounted again with the default block cache, without a cache and resident, and
+	every file is opened and read through in 0x200 byte reads like the Test menu benchmark.
+	Each step reports wall time and the fseeks, freads and bytes it cost. Without an image,
+	one with 64 folders of 40 files each is written to build/ and used.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nds.h>
+
+#include "nitrofs.h"
+#include "nitroimg.h"
+
+#define DEFAULT_IMAGE "build/bench.nds"
+#define DEFAULT_DIRS 64
+#define DEFAULT_FILES 40
+
+//read size for the full reads, what a stdio reader would typically ask for
+#define BENCH_BUFFER 0x200
+
+//nitroFSSetResident() limit for the resident run, big enough for any ROM
+#define BENCH_RESIDENT 0x10000000
+
+typedef struct {
+	char** paths;	//without the device name
+	int count;
+	int cap;
+	int dirs;
+} PathList;
+
+typedef struct {
+	FILE* file;
+	off_t lastpos;
+	u32 fntOffset;
+	u32 fatOffset;
+	u32 seeks;
+	u32 reads;
+	u32 bytes;
+} Walker;
+
+static double _milliseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static bool _addPath(PathList* list, char const* path)
+{
+	if (list->count >= list->cap)
+	{
+		int cap = list->cap ? list->cap * 2 : 256;
+		char** p = (char**)realloc(list->paths, cap * sizeof(char*));
+		if (!p) return false;
+
+		list->paths = p;
+		list->cap = cap;
+	}
+
+	list->paths[list->count] = strdup(path);
+	return list->paths[list->count++] != NULL;
+}
+
+static void _freePaths(PathList* list)
+{
+	for (int i = 0; i < list->count; i++)
+		free(list->paths[i]);
+
+	free(list->paths);
+	memset(list, 0, sizeof(*list));
+}
+
+//every file below path, through the nitro: directory functions
+static bool _listFiles(char const* path, PathList* list)
+{
+	struct _reent r = { 0 };
+	struct nitroDIRStruct dirStruct;
+	DIR_ITER dirState = { 0, &dirStruct };
+
+	if (!nitroFSDirOpen(&r, &dirState, path[0] ? path : "/"))
+		return false;
+
+	char name[NITRONAMELENMAX];
+	char sub[NITROMAXPATHLEN * 2];
+	struct stat st;
+	bool result = true;
+
+	while (result && nitroFSDirNext(&r, &dirState, name, &st) == 0)
+	{
+		if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			continue;
+
+		snprintf(sub, sizeof(sub), "%s/%s", path, name);
+
+		if (st.st_mode == S_IFDIR)
+		{
+			list->dirs++;
+			result = _listFiles(sub, list);
+		}
+		else
+		{
+			result = _addPath(list, sub);
+		}
+	}
+
+	return result;
+}
+
+static void _walkRead(Walker* w, off_t pos, void* ptr, size_t len)
+{
+	if (w->lastpos != pos)
+	{
+		fseek(w->file, pos, SEEK_SET);
+		w->seeks++;
+	}
+
+	size_t got = fread(ptr, 1, len, w->file);
+	w->lastpos = pos + got;
+	w->reads++;
+	w->bytes += got;
+}
+
+//looks name up in dir the old way, entry by entry. returns the file or dir id, -1 if it isn't there
+static int _walkFind(Walker* w, u16 dir, char const* name, size_t len, bool wantDir)
+{
+	struct ROM_FNTDir table;
+	_walkRead(w, w->fntOffset + (dir & NITRODIRMASK) * sizeof(table), &table, sizeof(table));
+
+	u32 pos = table.entry_start;
+	u16 file = table.entry_file_id;
+	char entry[NITRONAMELENMAX];
+
+	while (1)
+	{
+		u8 next = 0;
+		_walkRead(w, w->fntOffset + pos, &next, 1);
+
+		if (next == 0)
+			return -1;
+
+		u8 entryLen = next & (NITROISDIR ^ 0xFF);
+		_walkRead(w, w->fntOffset + pos + 1, entry, entryLen);
+
+		bool match = (entryLen == len && memcmp(entry, name, len) == 0);
+
+		if (next & NITROISDIR)
+		{
+			u16 id;
+			_walkRead(w, w->fntOffset + pos + 1 + entryLen, &id, sizeof(id));
+			pos += 1 + entryLen + sizeof(id);
+
+			if (match && wantDir)
+				return id;
+		}
+		else
+		{
+			struct ROM_FAT fat;
+			_walkRead(w, w->fatOffset + file * sizeof(fat), &fat, sizeof(fat));
+			pos += 1 + entryLen;
+
+			if (match && !wantDir)
+				return file;
+
+			file++;
+		}
+	}
+}
+
+static int _walkLookup(Walker* w, char const* path)
+{
+	int id = NITROROOT;
+
+	while (*path == '/')
+		path++;
+
+	char const* slash;
+
+	while ((slash = strchr(path, '/')))
+	{
+		if ((id = _walkFind(w, id, path, slash - path, true)) < 0)
+			return -1;
+
+		path = slash + 1;
+	}
+
+	return _walkFind(w, id, path, strlen(path), false);
+}
+
+static bool _writeDefaultImage()
+{
+	int count = DEFAULT_DIRS * DEFAULT_FILES;
+	NitroImageFile* files = (NitroImageFile*)calloc(count, sizeof(NitroImageFile));
+	char (*paths)[64] = malloc(count * 64);
+	static const char data[256];
+
+	if (!files || !paths)
+	{
+		free(files);
+		free(paths);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(paths[i], "data/folder%02d/file_%03d.bin", i / DEFAULT_FILES, i % DEFAULT_FILES);
+		files[i].path = paths[i];
+		files[i].data = data;
+		files[i].size = sizeof(data);
+	}
+
+	mkdir("build", 0777);
+	bool result = nitroImageWrite(DEFAULT_IMAGE, files, count);
+
+	free(files);
+	free(paths);
+	return result;
+}
+
+//mounts image again as set up now and reads every file through, the mount included
+static bool _benchReads(char const* image, char const* label, PathList const* list)
+{
+	struct nitroCacheStats stats;
+	struct _reent r = { 0 };
+	struct nitroFSStruct fs;
+	char buffer[BENCH_BUFFER];
+	u64 total = 0;
+	int missing = 0;
+
+	nitroFSResetCacheStats();
+	double start = _milliseconds();
+
+	if (!nitroFSInit(image))
+		return false;
+
+	for (int i = 0; i < list->count; i++)
+	{
+		if (nitroFSOpen(&r, &fs, list->paths[i], 0, 0) != 0)
+		{
+			missing++;
+			continue;
+		}
+
+		ssize_t got;
+		while ((got = nitroFSRead(&r, &fs, buffer, sizeof(buffer))) > 0)
+			total += got;
+
+		nitroFSClose(&r, &fs);
+	}
+
+	double elapsed = _milliseconds() - start;
+	nitroFSGetCacheStats(&stats);
+
+	printf("  %-14s %8.2f ms  %6u fseeks  %6u freads  %9u bytes  (%llu read, %u hits, %u misses)\n",
+		   label, elapsed, stats.deviceSeeks, stats.deviceReads, stats.deviceBytes,
+		   (unsigned long long)total, stats.hits, stats.misses);
+
+	if (missing > 0)
+		printf("  %d files failed to open\n", missing);
+
+	return missing == 0;
+}
+
+static bool _benchImage(char const* image)
+{
+	nitroFSResetCacheStats();
+	double start = _milliseconds();
+
+	if (!nitroFSInit(image))
+	{
+		printf("%s: no NitroFS\n", image);
+		return false;
+	}
+
+	double mounted = _milliseconds();
+
+	struct nitroCacheStats stats;
+	nitroFSGetCacheStats(&stats);
+
+	PathList list = { 0 };
+	if (!_listFiles("", &list))
+	{
+		printf("%s: can't list the files\n", image);
+		_freePaths(&list);
+		return false;
+	}
+
+	printf("%s: %d files in %d folders\n", image, list.count, list.dirs);
+	printf("  index mount    %8.2f ms  %6u fseeks  %6u freads  %9u bytes\n",
+		   mounted - start, stats.deviceSeeks, stats.deviceReads, stats.deviceBytes);
+
+	//after: nitroFSOpen() on the index
+	struct _reent r = { 0 };
+	struct nitroFSStruct fs;
+	int missing = 0;
+
+	nitroFSResetCacheStats();
+	start = _milliseconds();
+
+	for (int i = 0; i < list.count; i++)
+	{
+		if (nitroFSOpen(&r, &fs, list.paths[i], 0, 0) != 0)
+			missing++;
+		else
+			nitroFSClose(&r, &fs);
+	}
+
+	double indexed = _milliseconds() - start;
+	nitroFSGetCacheStats(&stats);
+
+	printf("  index lookups  %8.2f ms  %6u fseeks  %6u freads  %9u bytes\n",
+		   indexed, stats.deviceSeeks, stats.deviceReads, stats.deviceBytes);
+
+	//before: the FNT walk on the unbuffered image
+	Walker w = { 0 };
+	w.file = fopen(image, "rb");
+
+	if (w.file)
+	{
+		setvbuf(w.file, NULL, _IONBF, 0);
+		w.lastpos = -1;
+
+		_walkRead(&w, FNTOFFSET, &w.fntOffset, sizeof(w.fntOffset));
+		_walkRead(&w, FATOFFSET, &w.fatOffset, sizeof(w.fatOffset));
+		w.seeks = w.reads = w.bytes = 0;
+
+		start = _milliseconds();
+
+		for (int i = 0; i < list.count; i++)
+		{
+			if (_walkLookup(&w, list.paths[i]) < 0)
+				missing++;
+		}
+
+		double walked = _milliseconds() - start;
+		fclose(w.file);
+
+		printf("  FNT walk       %8.2f ms  %6u fseeks  %6u freads  %9u bytes\n",
+			   walked, w.seeks, w.reads, w.bytes);
+	}
+
+	if (missing > 0)
+		printf("  %d lookups failed\n", missing);
+
+	//whole files, with each way the image can be read
+	bool result = missing == 0;
+
+	result = _benchReads(image, "read, cache", &list) && result;
+
+	nitroFSSetCache(0, NITROCACHEBLOCKSIZE);
+	result = _benchReads(image, "read, no cache", &list) && result;
+	nitroFSSetCache(NITROCACHEBLOCKS, NITROCACHEBLOCKSIZE);
+
+	nitroFSSetResident(BENCH_RESIDENT);
+	result = _benchReads(image, "read, resident", &list) && result;
+	nitroFSSetResident(0);
+
+	_freePaths(&list);
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	bool result = true;
+
+	if (argc < 2)
+	{
+		if (!_writeDefaultImage())
+		{
+			printf("can't write %s\n", DEFAULT_IMAGE);
+			return 1;
+		}
+
+		result = _benchImage(DEFAULT_IMAGE);
+	}
+
+	for (int i = 1; i < argc; i++)
+		result = _benchImage(argv[i]) && result;
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	bench_sha1 - times the software SHA-1 in source/sha1.c
+
+	usage: bench_sha1
+
+	Hashes buffers from a single block up to the size of an app with sha1Calc(), and the
+	largest once more fed through sha1Update() in the 0x200 byte pieces a reader hands it,
+	each over and over for about BENCH_TIME ms. Reports MB/s for each. The DSi BIOS SHA-1
+	isn't on the host, so this is the software path the app falls back to in DS mode.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nds.h>
+
+#include "sha1.h"
+
+//how long each size is hashed for
+#define BENCH_TIME 250.0
+
+//what a reader hands sha1Update() at a time
+#define BENCH_PIECE 0x200
+
+static double _milliseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+//hashes size bytes until BENCH_TIME is up, pieces > 0 feeds them through sha1Update() that size at a time
+static void _bench(u8 const* data, u32 size, u32 piece, u8* digest)
+{
+	u64 bytes = 0;
+	double start = _milliseconds();
+	double elapsed = 0;
+
+	do
+	{
+		if (piece == 0)
+		{
+			sha1Calc(digest, data, size);
+		}
+		else
+		{
+			Sha1Context ctx;
+			sha1Init(&ctx);
+
+			for (u32 pos = 0; pos < size; pos += piece)
+				sha1Update(&ctx, data + pos, (size - pos < piece) ? size - pos : piece);
+
+			sha1Final(digest, &ctx);
+		}
+
+		bytes += size;
+		elapsed = _milliseconds() - start;
+	}
+	while (elapsed < BENCH_TIME);
+
+	char what[32];
+	if (piece == 0)
+		sprintf(what, "%u bytes", size);
+	else
+		sprintf(what, "%u bytes in 0x%X", size, piece);
+
+	printf("  %-24s %8.1f MB/s\n", what, bytes / (elapsed / 1000.0) / (1024.0 * 1024.0));
+}
+
+int main(int argc, char* argv[])
+{
+	u32 const sizes[] = { 64, 0x1000, 0x10000, 0x100000 };
+	u32 const largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+	u8* data = (u8*)malloc(largest);
+	if (!data)
+	{
+		printf("out of memory\n");
+		return 1;
+	}
+
+	u32 seed = 5;
+	for (u32 i = 0; i < largest; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+
+	//the digests are checked against each other so the hashing can't be left out
+	u8 whole[SHA1_DIGEST_LENGTH];
+	u8 pieces[SHA1_DIGEST_LENGTH];
+
+	sha1SetBios(false);
+	printf("bench_sha1: software SHA-1\n");
+
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		_bench(data, sizes[i], 0, whole);
+
+	_bench(data, largest, BENCH_PIECE, pieces);
+	free(data);
+
+	if (memcmp(whole, pieces, SHA1_DIGEST_LENGTH) != 0)
+	{
+		printf("sha1Calc() and sha1Update() disagree\n");
+		return 1;
+	}
+
+	return 0;
+}
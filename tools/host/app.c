@@ -0,0 +1,60 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Host stand-ins for the parts of the app that draw on the DS screens or need storage.c.
+*/
+
+#include <sys/stat.h>
+
+#include <nds.h>
+
+#include "main.h"
+#include "storage.h"
+
+PrintConsole topScreen;
+PrintConsole bottomScreen;
+
+void clearScreen(PrintConsole* screen)
+{
+}
+
+void printBytes(unsigned long long bytes)
+{
+	printf("%llu bytes", bytes);
+}
+
+void printProgressBar(float percent)
+{
+}
+
+void clearProgressBar()
+{
+}
+
+//the free space ledger lives in storage.c, which the host programs don't link
+void sdLedgerResize(unsigned long long oldSize, unsigned long long newSize)
+{
+}
+
+unsigned long long getFileSizePath(char const* path)
+{
+	struct stat st;
+	return (path && stat(path, &st) == 0) ? st.st_size : 0;
+}
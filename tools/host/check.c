@@ -0,0 +1,43 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+
+#include "check.h"
+
+static int failures = 0;
+
+void check(bool ok, char const* what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		failures += 1;
+	}
+}
+
+int checkResult(char const* name)
+{
+	if (failures)
+		printf("%s: %d failed\n", name, failures);
+	else
+		printf("%s: ok\n", name);
+
+	return failures ? 1 : 0;
+}
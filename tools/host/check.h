@@ -0,0 +1,36 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	The pass/fail bookkeeping the host tests share. A test calls check() for each thing it
+	checks and returns checkResult() from main().
+*/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <nds/ndstypes.h>
+
+//prints what failed, the test goes on
+void check(bool ok, char const* what);
+
+//prints "<name>: ok" or how many checks failed, the exit code for main()
+int checkResult(char const* name);
+
+#endif
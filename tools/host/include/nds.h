@@ -0,0 +1,93 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Host stand-in for the parts of libnds the app sources in tools/ are built with.
+	Only what those sources use is here, see host/libnds.c for the functions.
+*/
+
+#ifndef HOST_NDS_H
+#define HOST_NDS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds/ndstypes.h>
+#include <nds/memory.h>
+
+//no ITCM on the host
+#define ITCM_CODE
+#define __itcm
+
+//never no$gba, so nitroFSInit() doesn't look at the GBA slot in DSi mode
+#define NITRONOCASHID "host"
+
+#define BIT(n) (1 << (n))
+#define BUS_CLOCK 33513982
+#define timerTicks2msec(ticks) ((u32)(((u64)(ticks) * 1000) / BUS_CLOCK))
+
+#define iprintf printf
+
+//DSi mode unless a test says otherwise
+extern bool hostDSiMode;
+bool isDSiMode(void);
+
+//console output goes to stdout, the consoles themselves don't exist
+typedef struct PrintConsole {
+	int unused;
+} PrintConsole;
+
+PrintConsole* consoleSelect(PrintConsole* console);
+
+//one timer like libnds, so timings can't nest here either
+void cpuStartTiming(int timer);
+u32 cpuGetTiming(void);
+u32 cpuEndTiming(void);
+
+u16 swiCRC16(u16 crc, void const* data, u32 size);
+
+typedef struct swiSHA1context {
+	u32 state[5];
+	u32 total[2];
+	u8 buffer[64];
+	u32 fragment_size;
+	void (*sha_block)(struct swiSHA1context* ctx, const void* src, size_t len);
+} swiSHA1context_t;
+
+//there is no BIOS to hash with on the host, these abort
+void swiSHA1Init(swiSHA1context_t* ctx);
+void swiSHA1Update(swiSHA1context_t* ctx, void const* data, size_t len);
+void swiSHA1Final(void* digest, swiSHA1context_t* ctx);
+void swiSHA1Calc(void* digest, void const* data, size_t len);
+
+typedef struct {
+	u8 language;
+} tPERSONAL;
+
+extern tPERSONAL hostPersonalData;
+#define PersonalData (&hostPersonalData)
+
+//an empty GBA slot
+extern u16 hostGbaRom[0x200];
+#define GBAROM hostGbaRom
+#define BUS_OWNER_ARM9 1
+void sysSetCartOwner(int owner);
+
+#endif
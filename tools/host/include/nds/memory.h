@@ -0,0 +1,81 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_NDS_MEMORY_H
+#define HOST_NDS_MEMORY_H
+
+#include <nds/ndstypes.h>
+
+//the cartridge header as libnds lays it out, only the fields the app reads are named
+typedef struct {
+	char gameTitle[12];
+	char gameCode[4];
+	char makercode[2];
+	u8 unitCode;
+	u8 deviceType;
+	u8 deviceSize;
+	u8 reserved1[9];
+	u8 romversion;
+	u8 flags;
+	u32 arm9romOffset;
+	u32 arm9executeAddress;
+	u32 arm9destination;
+	u32 arm9binarySize;
+	u32 arm7romOffset;
+	u32 arm7executeAddress;
+	u32 arm7destination;
+	u32 arm7binarySize;
+	u32 filenameOffset;
+	u32 filenameSize;
+	u32 fatOffset;
+	u32 fatSize;
+	u32 arm9overlaySource;
+	u32 arm9overlaySize;
+	u32 arm7overlaySource;
+	u32 arm7overlaySize;
+	u32 cardControl13;
+	u32 cardControlBF;
+	u32 bannerOffset;
+	u16 secureCRC16;
+	u16 readTimeout;
+	u32 unknownRAM1;
+	u32 unknownRAM2;
+	u32 bfPrime1;
+	u32 bfPrime2;
+	u32 romSize;
+	u32 headerSize;
+	u32 zeros88[14];
+	u8 gbaLogo[156];
+	u16 logoCRC16;
+	u16 headerCRC16;
+} tNDSHeader;
+
+typedef struct {
+	tNDSHeader ndshdr;
+	u8 reserved[0x230 - 0x160];
+	u32 tid_low;
+	u32 tid_high;
+	u8 reserved2[0xF80 - 0x238];
+	u8 rsa_signature[0x80];
+} tDSiHeader;
+
+_Static_assert(sizeof(tNDSHeader) == 0x160, "tNDSHeader");
+_Static_assert(sizeof(tDSiHeader) == 0x1000, "tDSiHeader");
+
+#endif
@@ -0,0 +1,74 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Host stand-in for the libsysbase device table. Lookups follow libsysbase: a name
+	without a colon means the default device, so callers have to pass "name:".
+*/
+
+#ifndef HOST_SYS_IOSUPPORT_H
+#define HOST_SYS_IOSUPPORT_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+struct _reent {
+	int _errno;
+	void* deviceData;
+};
+
+typedef struct {
+	int device;
+	void* dirStruct;
+} DIR_ITER;
+
+typedef struct {
+	const char* name;
+	int structSize;
+	int (*open_r)(struct _reent* r, void* fileStruct, const char* path, int flags, int mode);
+	int (*close_r)(struct _reent* r, void* fd);
+	ssize_t (*write_r)(struct _reent* r, void* fd, const char* ptr, size_t len);
+	ssize_t (*read_r)(struct _reent* r, void* fd, char* ptr, size_t len);
+	off_t (*seek_r)(struct _reent* r, void* fd, off_t pos, int dir);
+	int (*fstat_r)(struct _reent* r, void* fd, struct stat* st);
+	int (*stat_r)(struct _reent* r, const char* file, struct stat* st);
+	int (*link_r)(struct _reent* r, const char* existing, const char* newLink);
+	int (*unlink_r)(struct _reent* r, const char* name);
+	int (*chdir_r)(struct _reent* r, const char* name);
+	int (*rename_r)(struct _reent* r, const char* oldName, const char* newName);
+	int (*mkdir_r)(struct _reent* r, const char* path, int mode);
+	int dirStateSize;
+	DIR_ITER* (*diropen_r)(struct _reent* r, DIR_ITER* dirState, const char* path);
+	int (*dirreset_r)(struct _reent* r, DIR_ITER* dirState);
+	int (*dirnext_r)(struct _reent* r, DIR_ITER* dirState, char* filename, struct stat* filestat);
+	int (*dirclose_r)(struct _reent* r, DIR_ITER* dirState);
+	int (*statvfs_r)(struct _reent* r, const char* path, struct statvfs* buf);
+	int (*ftruncate_r)(struct _reent* r, void* fd, off_t len);
+	int (*fsync_r)(struct _reent* r, void* fd);
+	void* deviceData;
+} devoptab_t;
+
+int AddDevice(const devoptab_t* device);
+int FindDevice(const char* name);
+int RemoveDevice(const char* name);
+void setDefaultDevice(int device);
+const devoptab_t* GetDeviceOpTab(const char* name);
+
+#endif
@@ -0,0 +1,195 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Host stand-ins for the libnds and libsysbase functions the app sources use.
+*/
+
+#include <string.h>
+#include <time.h>
+
+#include <nds.h>
+#include <sys/iosupport.h>
+
+#include "tonccpy.h"
+
+#define STD_MAX 16
+
+bool hostDSiMode = true;
+tPERSONAL hostPersonalData = { 1 };	//English
+
+bool isDSiMode(void)
+{
+	return hostDSiMode;
+}
+
+PrintConsole* consoleSelect(PrintConsole* console)
+{
+	return console;
+}
+
+u16 hostGbaRom[0x200];
+
+void sysSetCartOwner(int owner)
+{
+}
+
+//tonclib's VRAM safe copy, there is no VRAM here
+void tonccpy(void* dst, const void* src, unsigned int size)
+{
+	memcpy(dst, src, size);
+}
+
+static u64 timingStart = 0;
+
+static u64 _nanoseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void cpuStartTiming(int timer)
+{
+	timingStart = _nanoseconds();
+}
+
+u32 cpuGetTiming(void)
+{
+	return (u32)((double)(_nanoseconds() - timingStart) * BUS_CLOCK / 1e9);
+}
+
+u32 cpuEndTiming(void)
+{
+	return cpuGetTiming();
+}
+
+//the BIOS CRC16, one bit at a time
+u16 swiCRC16(u16 crc, void const* data, u32 size)
+{
+	u8 const* p = (u8 const*)data;
+
+	for (u32 i = 0; i < size; i++)
+	{
+		crc ^= p[i];
+
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void _noBios(char const* name)
+{
+	fprintf(stderr, "%s: there is no BIOS on the host\n", name);
+	abort();
+}
+
+void swiSHA1Init(swiSHA1context_t* ctx)
+{
+	_noBios("swiSHA1Init");
+}
+
+void swiSHA1Update(swiSHA1context_t* ctx, void const* data, size_t len)
+{
+	_noBios("swiSHA1Update");
+}
+
+void swiSHA1Final(void* digest, swiSHA1context_t* ctx)
+{
+	_noBios("swiSHA1Final");
+}
+
+void swiSHA1Calc(void* digest, void const* data, size_t len)
+{
+	_noBios("swiSHA1Calc");
+}
+
+//device table, slots 0 to 2 are the standard streams like in libsysbase
+static const devoptab_t stdNull = { "stdnull" };
+
+static const devoptab_t* devices[STD_MAX] = {
+	&stdNull,
+	&stdNull,
+	&stdNull
+};
+
+static int defaultDevice = 0;
+
+int FindDevice(const char* name)
+{
+	if (!strchr(name, ':'))
+		return defaultDevice;
+
+	for (int i = 0; i < STD_MAX; i++)
+	{
+		if (!devices[i])
+			continue;
+
+		int len = strlen(devices[i]->name);
+
+		if (strncmp(devices[i]->name, name, len) == 0 && name[len] == ':')
+			return i;
+	}
+
+	return -1;
+}
+
+int AddDevice(const devoptab_t* device)
+{
+	//a device with the same name is replaced
+	for (int i = 3; i < STD_MAX; i++)
+	{
+		if (!devices[i] || devices[i] == &stdNull || strcmp(devices[i]->name, device->name) == 0)
+		{
+			devices[i] = device;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int RemoveDevice(const char* name)
+{
+	int dev = FindDevice(name);
+
+	if (dev < 0)
+		return -1;
+
+	devices[dev] = &stdNull;
+	return 0;
+}
+
+void setDefaultDevice(int device)
+{
+	if (device >= 0 && device < STD_MAX && devices[device])
+		defaultDevice = device;
+}
+
+const devoptab_t* GetDeviceOpTab(const char* name)
+{
+	int dev = FindDevice(name);
+
+	if (dev < 0)
+		return NULL;
+
+	return devices[dev];
+}
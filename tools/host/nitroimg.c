@@ -0,0 +1,246 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nitroimg.h"
+
+#define SECTOR 0x200
+#define MAX_NAME 127
+
+typedef struct {
+	char name[MAX_NAME+1];
+	int parent;
+	int firstFile;	//id of the first file listed in the folder
+} ImageDir;
+
+typedef struct {
+	u8* data;
+	u32 size;
+	u32 cap;
+} Buffer;
+
+static bool _put(Buffer* b, void const* data, u32 len)
+{
+	if (b->size + len > b->cap)
+	{
+		u32 cap = b->cap ? b->cap : 0x1000;
+		while (cap < b->size + len)
+			cap *= 2;
+
+		u8* p = (u8*)realloc(b->data, cap);
+		if (!p) return false;
+
+		b->data = p;
+		b->cap = cap;
+	}
+
+	memcpy(b->data + b->size, data, len);
+	b->size += len;
+	return true;
+}
+
+static u32 _align(u32 value)
+{
+	return (value + SECTOR - 1) & ~(SECTOR - 1);
+}
+
+//index of folder name in parent, made if it isn't there yet. -1 if there are too many
+static int _findDir(ImageDir* dirs, int* dirCount, int parent, char const* name, int len)
+{
+	for (int i = 1; i < *dirCount; i++)
+	{
+		if (dirs[i].parent == parent && (int)strlen(dirs[i].name) == len && memcmp(dirs[i].name, name, len) == 0)
+			return i;
+	}
+
+	if (*dirCount >= 0x1000 || len > MAX_NAME)
+		return -1;
+
+	ImageDir* d = &dirs[(*dirCount)++];
+	memcpy(d->name, name, len);
+	d->name[len] = '\0';
+	d->parent = parent;
+	return *dirCount - 1;
+}
+
+//folder a file goes in, and where its own name starts
+static int _fileDir(ImageDir* dirs, int* dirCount, char const* path, char const** name)
+{
+	int dir = 0;
+	char const* slash;
+
+	while ((slash = strchr(path, '/')))
+	{
+		if ((dir = _findDir(dirs, dirCount, dir, path, slash - path)) < 0)
+			return -1;
+
+		path = slash + 1;
+	}
+
+	*name = path;
+	return dir;
+}
+
+//lays out the FNT: the main table, then each folder's sub-table with its files and then its folders
+static bool _buildFnt(ImageDir* dirs, int dirCount, int const* fileDirs, int const* fileIds, NitroImageFile const* files, int count, Buffer* fnt)
+{
+	Buffer tables = { 0 };
+	bool result = true;
+	u32 mainSize = dirCount * 8;
+
+	for (int d = 0; d < dirCount && result; d++)
+	{
+		u32 start = mainSize + tables.size;
+		u16 firstFile = dirs[d].firstFile;
+		u16 parent = (d == 0) ? dirCount : 0xF000 | dirs[d].parent;
+
+		result = _put(fnt, &start, 4) && _put(fnt, &firstFile, 2) && _put(fnt, &parent, 2);
+
+		for (int id = dirs[d].firstFile; id < count && result; id++)
+		{
+			int i = 0;
+			while (fileIds[i] != id) i++;
+
+			if (fileDirs[i] != d)
+				break;
+
+			char const* name = strrchr(files[i].path, '/');
+			name = name ? name + 1 : files[i].path;
+			u8 len = strlen(name);
+
+			result = _put(&tables, &len, 1) && _put(&tables, name, len);
+		}
+
+		for (int s = 1; s < dirCount && result; s++)
+		{
+			if (dirs[s].parent != d)
+				continue;
+
+			u8 len = strlen(dirs[s].name);
+			u8 flag = 0x80 | len;
+			u16 id = 0xF000 | s;
+
+			result = _put(&tables, &flag, 1) && _put(&tables, dirs[s].name, len) && _put(&tables, &id, 2);
+		}
+
+		u8 end = 0;
+		result = result && _put(&tables, &end, 1);
+	}
+
+	result = result && _put(fnt, tables.data, tables.size);
+
+	free(tables.data);
+	return result;
+}
+
+//header, FNT, FAT, then the files each on their own sector
+static bool _writeImage(char const* imagePath, Buffer const* fnt, int const* fileIds, NitroImageFile const* files, int count)
+{
+	u32 fntOffset = SECTOR;
+	u32 fatOffset = _align(fntOffset + fnt->size);
+	u32 fatSize = count * 8;
+	u32 dataOffset = _align(fatOffset + fatSize);
+
+	FILE* f = fopen(imagePath, "wb");
+	if (!f) return false;
+
+	u8 header[SECTOR] = { 0 };
+	memcpy(header, "NITROFS TEST", 12);
+	memcpy(header + 0x0C, "HOST", 4);
+	memcpy(header + 0x40, &fntOffset, 4);
+	memcpy(header + 0x44, &fnt->size, 4);
+	memcpy(header + 0x48, &fatOffset, 4);
+	memcpy(header + 0x4C, &fatSize, 4);
+
+	bool result = (fwrite(header, 1, SECTOR, f) == SECTOR &&
+				   fwrite(fnt->data, 1, fnt->size, f) == fnt->size);
+
+	u32 pos = dataOffset;
+	u32 end = dataOffset;
+
+	for (int id = 0; id < count && result; id++)
+	{
+		int i = 0;
+		while (fileIds[i] != id) i++;
+
+		u32 entry[2] = { pos, pos + files[i].size };
+
+		result = (fseek(f, fatOffset + id * 8, SEEK_SET) == 0 &&
+				  fwrite(entry, 1, sizeof(entry), f) == sizeof(entry) &&
+				  fseek(f, pos, SEEK_SET) == 0 &&
+				  fwrite(files[i].data, 1, files[i].size, f) == files[i].size);
+
+		end = pos + files[i].size;
+		pos = _align(end);
+	}
+
+	//the last file is padded out to its sector too
+	if (result && pos > end)
+		result = (fseek(f, pos - 1, SEEK_SET) == 0 && fputc(0, f) == 0);
+
+	if (fclose(f) != 0)
+		result = false;
+
+	return result;
+}
+
+bool nitroImageWrite(char const* imagePath, NitroImageFile const* files, int count)
+{
+	ImageDir* dirs = (ImageDir*)calloc(0x1000, sizeof(ImageDir));
+	int* fileDirs = (int*)malloc((count + 1) * sizeof(int));
+	int* fileIds = (int*)malloc((count + 1) * sizeof(int));
+	Buffer fnt = { 0 };
+	bool result = (dirs && fileDirs && fileIds);
+
+	int dirCount = 1;
+	char const* name;
+
+	for (int i = 0; i < count && result; i++)
+	{
+		fileDirs[i] = _fileDir(dirs, &dirCount, files[i].path, &name);
+		result = (fileDirs[i] >= 0 && strlen(name) <= MAX_NAME);
+	}
+
+	//file ids run on through each folder in turn
+	int nextId = 0;
+
+	for (int d = 0; d < dirCount && result; d++)
+	{
+		dirs[d].firstFile = nextId;
+
+		for (int i = 0; i < count; i++)
+		{
+			if (fileDirs[i] == d)
+				fileIds[i] = nextId++;
+		}
+	}
+
+	result = result &&
+			 _buildFnt(dirs, dirCount, fileDirs, fileIds, files, count, &fnt) &&
+			 _writeImage(imagePath, &fnt, fileIds, files, count);
+
+	free(dirs);
+	free(fileDirs);
+	free(fileIds);
+	free(fnt.data);
+	return result;
+}
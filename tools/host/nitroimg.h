@@ -0,0 +1,39 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Writes bare .nds images holding only a header and a NitroFS, for the host tests and
+	benchmarks of source/nitrofs.c.
+*/
+
+#ifndef NITROIMG_H
+#define NITROIMG_H
+
+#include <nds/ndstypes.h>
+
+typedef struct {
+	char const* path;	//inside the image, folders separated by '/'
+	void const* data;
+	u32 size;
+} NitroImageFile;
+
+//folders are made as the paths need them, files are stored in the order given
+bool nitroImageWrite(char const* imagePath, NitroImageFile const* files, int count);
+
+#endif
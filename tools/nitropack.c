@@ -0,0 +1,401 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+	nitropack - lays out the NitroFS file data of a built .nds for nitrofs.c
+
+	usage: nitropack <image.nds> [path ...]
+
+	Rewrites the file data area in place: the listed paths first, in the order given, then
+	every other file in FAT order, each starting on a 0x200 sector. Everything before the
+	first file (header, binaries, FNT, FAT, banner) stays where ndstool put it, only the FAT
+	entries, the used ROM size and the header CRC change. The result is read back and
+	compared with the original before it is written, and a layout report goes to stdout.
+
+	Images it can't safely repack (anything other than file data after the first file, or a
+	DSi header with digests over that area) are left as they are, with a note on stderr saying
+	so. Errors go to stderr too.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR 0x200
+#define ROOT 0xF000
+
+typedef struct {
+	char path[512];
+	uint16_t id;
+	uint32_t top;
+	uint32_t size;
+} PackFile;
+
+static uint8_t* image = NULL;
+static uint32_t imageSize = 0;
+
+static PackFile* files = NULL;
+static int fileCount = 0;
+
+static uint32_t _get32(uint32_t offset)
+{
+	if (offset + 4 > imageSize) return 0;
+	return image[offset] | (image[offset + 1] << 8) | (image[offset + 2] << 16) | ((uint32_t)image[offset + 3] << 24);
+}
+
+static uint16_t _get16(uint32_t offset)
+{
+	if (offset + 2 > imageSize) return 0;
+	return image[offset] | (image[offset + 1] << 8);
+}
+
+static void _put32(uint8_t* data, uint32_t offset, uint32_t value)
+{
+	data[offset] = value;
+	data[offset + 1] = value >> 8;
+	data[offset + 2] = value >> 16;
+	data[offset + 3] = value >> 24;
+}
+
+static uint32_t _align(uint32_t offset)
+{
+	return (offset + SECTOR - 1) & ~(SECTOR - 1);
+}
+
+//same crc as swiCRC16(0xFFFF, ...)
+static uint16_t _crc16(uint8_t const* data, uint32_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	for (uint32_t i = 0; i < len; i++)
+	{
+		crc ^= data[i];
+
+		for (int b = 0; b < 8; b++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+//walks the FNT, filling files with every file id below dir
+static bool _walk(uint32_t fnt, uint32_t fntSize, uint16_t dir, char const* prefix, int depth)
+{
+	if (depth > 64) return false;
+	if ((uint32_t)(dir & 0xFFF) * 8 + 8 > fntSize) return false;
+
+	uint32_t pos = fnt + _get32(fnt + (dir & 0xFFF) * 8);
+	uint16_t id = _get16(fnt + (dir & 0xFFF) * 8 + 4);
+
+	while (pos < fnt + fntSize && image[pos] != 0)
+	{
+		uint8_t len = image[pos] & 0x7F;
+		bool isDir = image[pos] & 0x80;
+		char path[512];
+
+		if (pos + 1 + len > fnt + fntSize) return false;
+		snprintf(path, sizeof(path), "%s/%.*s", prefix, len, (char const*)&image[pos + 1]);
+		pos += 1 + len;
+
+		if (isDir)
+		{
+			if (!_walk(fnt, fntSize, _get16(pos), path, depth + 1)) return false;
+			pos += 2;
+		}
+		else
+		{
+			files = (PackFile*)realloc(files, (fileCount + 1) * sizeof(PackFile));
+			snprintf(files[fileCount].path, sizeof(files[fileCount].path), "%s", path);
+			files[fileCount].id = id++;
+			fileCount++;
+		}
+	}
+
+	return true;
+}
+
+//true if a path given on the command line names f, with or without the .lz nitrofs hides
+static bool _matches(PackFile const* f, char const* want)
+{
+	char const* path = f->path + 1;
+
+	if (want[0] == '/') want++;
+	if (strcmp(path, want) == 0) return true;
+
+	size_t len = strlen(want);
+	return strncmp(path, want, len) == 0 && strcmp(path + len, ".lz") == 0;
+}
+
+//the end of the furthest thing that isn't nitro file data
+static uint32_t _fixedEnd(uint32_t fatCount, bool* isNitro)
+{
+	uint32_t end = 0;
+	uint32_t areas[][2] = {
+		{ _get32(0x20), _get32(0x2C) },	//arm9
+		{ _get32(0x30), _get32(0x3C) },	//arm7
+		{ _get32(0x40), _get32(0x44) },	//fnt
+		{ _get32(0x48), _get32(0x4C) },	//fat
+		{ _get32(0x50), _get32(0x54) },	//arm9 overlay table
+		{ _get32(0x58), _get32(0x5C) },	//arm7 overlay table
+	};
+
+	for (int i = 0; i < (int)(sizeof(areas) / sizeof(areas[0])); i++)
+	{
+		if (areas[i][1] > 0 && areas[i][0] + areas[i][1] > end)
+			end = areas[i][0] + areas[i][1];
+	}
+
+	//banner, its size depends on the version
+	uint32_t banner = _get32(0x68);
+	if (banner)
+	{
+		uint16_t version = _get16(banner);
+		uint32_t size = (version == 0x0103) ? 0x23C0 : (version == 3) ? 0xA40 : (version == 2) ? 0x940 : 0x840;
+		if (banner + size > end)
+			end = banner + size;
+	}
+
+	//overlays and anything else in the FAT that isn't in the FNT
+	for (uint32_t i = 0; i < fatCount; i++)
+	{
+		if (!isNitro[i] && _get32(_get32(0x48) + i * 8 + 4) > end)
+			end = _get32(_get32(0x48) + i * 8 + 4);
+	}
+
+	return end;
+}
+
+//a DSi header with anything pointing at or past start can't be repacked without redoing it
+static bool _twlBlocks(uint32_t start)
+{
+	if (!(image[0x12] & 2) || _get32(0x84) < 0x1000)
+		return false;
+
+	uint32_t const offsets[] = { 0x1C0, 0x1D0, 0x1E0, 0x1E8, 0x1F0, 0x1F8 };
+
+	for (int i = 0; i < (int)(sizeof(offsets) / sizeof(offsets[0])); i++)
+	{
+		uint32_t offset = _get32(offsets[i]);
+		uint32_t size = _get32(offsets[i] + 4);
+
+		if (offset != 0 && offset + size > start)
+			return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("usage: nitropack <image.nds> [path ...]\n");
+		return 1;
+	}
+
+	FILE* f = fopen(argv[1], "rb");
+	if (!f)
+	{
+		fprintf(stderr, "nitropack: can't open %s\n", argv[1]);
+		return 1;
+	}
+
+	fseek(f, 0, SEEK_END);
+	imageSize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	image = (uint8_t*)malloc(imageSize);
+	if (!image || imageSize < 0x200 || fread(image, 1, imageSize, f) != imageSize)
+	{
+		fprintf(stderr, "nitropack: can't read %s\n", argv[1]);
+		fclose(f);
+		return 1;
+	}
+
+	fclose(f);
+
+	uint32_t fnt = _get32(0x40);
+	uint32_t fntSize = _get32(0x44);
+	uint32_t fat = _get32(0x48);
+	uint32_t fatCount = _get32(0x4C) / 8;
+
+	if (fntSize < 8 || fnt + fntSize > imageSize || fat + fatCount * 8 > imageSize)
+	{
+		fprintf(stderr, "nitropack: %s has no NitroFS\n", argv[1]);
+		return 1;
+	}
+
+	if (!_walk(fnt, fntSize, ROOT, "", 0))
+	{
+		fprintf(stderr, "nitropack: bad FNT in %s\n", argv[1]);
+		return 1;
+	}
+
+	bool* isNitro = (bool*)calloc(fatCount, sizeof(bool));
+	uint32_t start = imageSize;
+	uint32_t end = 0;
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		PackFile* p = &files[i];
+
+		if (p->id >= fatCount)
+		{
+			fprintf(stderr, "nitropack: bad FAT in %s\n", argv[1]);
+			return 1;
+		}
+
+		isNitro[p->id] = true;
+		p->top = _get32(fat + p->id * 8);
+		p->size = _get32(fat + p->id * 8 + 4) - p->top;
+
+		if (p->size == 0) continue;
+
+		if (p->top + p->size > imageSize)
+		{
+			fprintf(stderr, "nitropack: bad FAT in %s\n", argv[1]);
+			return 1;
+		}
+
+		if (p->top < start) start = p->top;
+		if (p->top + p->size > end) end = p->top + p->size;
+	}
+
+	if (fileCount == 0 || end == 0)
+	{
+		fprintf(stderr, "nitropack: %s has no files to pack\n", argv[1]);
+		return 0;
+	}
+
+	if (_fixedEnd(fatCount, isNitro) > start || _get32(0x80) > _align(end))
+	{
+		fprintf(stderr, "nitropack: %s has more than file data after its first file, left as is\n", argv[1]);
+		return 0;
+	}
+
+	if (_twlBlocks(start))
+	{
+		fprintf(stderr, "nitropack: %s has DSi digests over its file data, left as is\n", argv[1]);
+		return 0;
+	}
+
+	//order: the listed paths, then the rest as they are in the FAT
+	PackFile** order = (PackFile**)malloc(fileCount * sizeof(PackFile*));
+	bool* placed = (bool*)calloc(fileCount, sizeof(bool));
+	int count = 0;
+
+	for (int a = 2; a < argc; a++)
+	{
+		for (int i = 0; i < fileCount; i++)
+		{
+			if (!placed[i] && _matches(&files[i], argv[a]))
+			{
+				order[count++] = &files[i];
+				placed[i] = true;
+			}
+		}
+	}
+
+	for (int i = 0; i < fileCount; i++)
+	{
+		if (!placed[i])
+			order[count++] = &files[i];
+	}
+
+	//lay it out
+	uint32_t base = _align(start);
+	uint32_t newEnd = base;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (order[i]->size > 0)
+			newEnd = _align(newEnd) + order[i]->size;
+	}
+
+	uint8_t* out = (uint8_t*)malloc(newEnd);
+	memcpy(out, image, start);
+	memset(out + start, 0xFF, newEnd - start);
+
+	printf("nitropack: %s\n", argv[1]);
+	printf("  %-10s %-10s %-6s %s\n", "offset", "size", "pad", "path");
+
+	uint32_t pos = base;
+	uint32_t padding = base - start;
+	uint32_t data = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		PackFile* p = order[i];
+		uint32_t top = pos;
+
+		if (p->size > 0)
+		{
+			top = _align(pos);
+			padding += top - pos;
+			memcpy(out + top, image + p->top, p->size);
+			pos = top + p->size;
+		}
+
+		_put32(out, fat + p->id * 8, top);
+		_put32(out, fat + p->id * 8 + 4, top + p->size);
+
+		data += p->size;
+		printf("  0x%08X 0x%08X %-6u %s\n", top, p->size, _align(p->size) - p->size, p->path);
+	}
+
+	_put32(out, 0x80, newEnd);
+	uint16_t crc = _crc16(out, 0x15E);
+	out[0x15E] = crc;
+	out[0x15F] = crc >> 8;
+
+	//read it back before trusting it
+	for (int i = 0; i < fileCount; i++)
+	{
+		uint32_t top = out[fat + files[i].id * 8] | (out[fat + files[i].id * 8 + 1] << 8) |
+			(out[fat + files[i].id * 8 + 2] << 16) | ((uint32_t)out[fat + files[i].id * 8 + 3] << 24);
+
+		if ((files[i].size > 0 && (top & (SECTOR - 1))) || top + files[i].size > newEnd ||
+			memcmp(out + top, image + files[i].top, files[i].size) != 0)
+		{
+			fprintf(stderr, "nitropack: check failed on %s, %s left as is\n", files[i].path, argv[1]);
+			return 1;
+		}
+	}
+
+	bool contiguous = (_align(fnt + fntSize) >= fat && fnt < fat) || (_align(fat + fatCount * 8) >= fnt && fat < fnt);
+
+	printf("  %d files, %u bytes of data, %u bytes of padding, %u sectors\n",
+		fileCount, data, padding, (newEnd - base + SECTOR - 1) / SECTOR);
+	printf("  FNT 0x%08X and FAT 0x%08X %s\n", fnt, fat, contiguous ? "contiguous" : "NOT contiguous");
+	printf("  image 0x%08X -> 0x%08X bytes\n", imageSize, newEnd);
+
+	f = fopen(argv[1], "wb");
+	if (!f || fwrite(out, 1, newEnd, f) != newEnd)
+	{
+		fprintf(stderr, "nitropack: can't write %s\n", argv[1]);
+		if (f) fclose(f);
+		return 1;
+	}
+
+	fclose(f);
+	return 0;
+}
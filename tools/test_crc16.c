@@ -0,0 +1,102 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_crc16 - checks the table driven crc16() in source/crc16.c against the bitwise CRC
+
+	usage: test_crc16
+
+	The BIOS swiCRC16() is reflected 0x8005 one bit at a time. crc16() has to give the same
+	result for every length, start alignment and starting value, including the odd bytes its
+	four at a time loop leaves over.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds.h>
+
+#include "check.h"
+#include "crc16.h"
+
+static u16 _crc16Bitwise(u16 crc, void const* data, u32 len)
+{
+	u8 const* p = (u8 const*)data;
+
+	for (u32 i = 0; i < len; i++)
+	{
+		crc ^= p[i];
+
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+int main(int argc, char* argv[])
+{
+	//CRC-16/MODBUS check value, the same CRC started at 0xFFFF
+	check(crc16(0xFFFF, "123456789", 9) == 0x4B37, "check value");
+	check(crc16(0xFFFF, NULL, 0) == 0xFFFF, "no data");
+
+	u8 data[0x1200];
+	u32 seed = 3;
+	for (u32 i = 0; i < sizeof(data); i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+
+	u16 const starts[] = { 0xFFFF, 0x0000, 0x1234 };
+	int mismatches = 0;
+
+	for (int s = 0; s < 3; s++)
+	{
+		for (u32 offset = 0; offset < 4; offset++)
+		{
+			for (u32 len = 0; len <= 300; len++)
+			{
+				if (crc16(starts[s], data + offset, len) != _crc16Bitwise(starts[s], data + offset, len))
+					mismatches++;
+			}
+		}
+	}
+
+	check(mismatches == 0, "short lengths");
+
+	//what install.c hashes: the NDS header, the banner icons and the whole DSi header
+	u32 const sizes[] = { 0x15E, 0x820, 0x920, 0xA20, 0x1000, 0x1180 };
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		char what[32];
+		sprintf(what, "0x%X bytes", sizes[i]);
+		check(crc16(0xFFFF, data, sizes[i]) == _crc16Bitwise(0xFFFF, data, sizes[i]), what);
+	}
+
+	//a CRC carried across calls, like the template export
+	u16 crc = 0xFFFF;
+	for (u32 pos = 0; pos < sizeof(data); pos += 333)
+		crc = crc16(crc, data + pos, (sizeof(data) - pos < 333) ? sizeof(data) - pos : 333);
+
+	check(crc == _crc16Bitwise(0xFFFF, data, sizeof(data)), "in pieces");
+
+	return checkResult("test_crc16");
+}
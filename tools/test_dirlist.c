@@ -0,0 +1,294 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_dirlist - checks the folder listing of source/dirlist.c against an in-memory sort
+
+	usage: test_dirlist [entries]
+
+	Fills a scratch folder with synthetic ROM names and some folders (100000 entries unless
+	given) and lists it sorted by name in DS mode, so it goes through spilled runs and the
+	merge. The result has to match the same names sorted in memory with qsort(), and the L/R
+	jump points have to fall exactly where the folder flag or the leading letter changes.
+	A small folder is then checked the same way through the in-memory path.
+*/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <nds.h>
+
+#include "check.h"
+#include "dirlist.h"
+
+#define SCRATCH_DIR "build/dirlist.tmp"
+
+typedef struct {
+	char name[64];
+	bool directory;
+} Name;
+
+static const char* words[] = {
+	"alpha", "Bravo", "CHARLIE", "delta", "Echo", "foxtrot", "Golf", "hotel",
+	"India", "juliett", "Kilo", "lima", "Mike", "november", "Oscar", "papa",
+	"Quebec", "romeo", "Sierra", "tango", "Uniform", "victor", "Whiskey", "x-ray",
+	"Yankee", "zulu"
+};
+
+//the order dirlist promises: folders first, then case-folded with digit runs by value
+static int _naturalCompare(char const* a, char const* b)
+{
+	while (*a != '\0' && *b != '\0')
+	{
+		if (isdigit((unsigned char)*a) && isdigit((unsigned char)*b))
+		{
+			int na = 0;
+			int nb = 0;
+
+			while (isdigit((unsigned char)a[na])) na++;
+			while (isdigit((unsigned char)b[nb])) nb++;
+
+			if (na != nb)
+				return na - nb;
+
+			int c = strncmp(a, b, na);
+			if (c != 0)
+				return c;
+
+			a += na;
+			b += nb;
+			continue;
+		}
+
+		int c = tolower((unsigned char)*a) - tolower((unsigned char)*b);
+		if (c != 0)
+			return c;
+
+		a++;
+		b++;
+	}
+
+	return tolower((unsigned char)*a) - tolower((unsigned char)*b);
+}
+
+static int _compareNames(const void* a, const void* b)
+{
+	const Name* na = (const Name*)a;
+	const Name* nb = (const Name*)b;
+
+	if (na->directory != nb->directory)
+		return na->directory ? -1 : 1;
+
+	return _naturalCompare(na->name, nb->name);
+}
+
+static int _group(const Name* n)
+{
+	int c = toupper((unsigned char)n->name[0]);
+	int letter = (c >= 'A' && c <= 'Z') ? 1 + (c - 'A') : 0;
+
+	return n->directory ? letter : 27 + letter;
+}
+
+//unique names, numbers never have leading zeros so no two names share a sort key
+static Name* _makeNames(int count)
+{
+	Name* names = (Name*)malloc(count * sizeof(Name));
+	if (!names) return NULL;
+
+	srand(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		char const* word = words[rand() % (sizeof(words) / sizeof(words[0]))];
+		names[i].directory = (i % 50 == 0);
+
+		if (names[i].directory)
+			sprintf(names[i].name, "%s folder %d", word, i);
+		else if (i % 7 == 0)
+			sprintf(names[i].name, "%d %s.nds", i, word);
+		else
+			sprintf(names[i].name, "%s %d - %d.nds", word, rand() % 100, i);
+	}
+
+	return names;
+}
+
+static bool _fillScratch(Name const* names, int count)
+{
+	mkdir("build", 0777);
+
+	if (mkdir(SCRATCH_DIR, 0777) != 0)
+	{
+		printf("can't make %s, remove it if it's left from an earlier run\n", SCRATCH_DIR);
+		return false;
+	}
+
+	char path[128];
+
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(path, "%s/%s", SCRATCH_DIR, names[i].name);
+
+		if (names[i].directory)
+		{
+			if (mkdir(path, 0777) != 0)
+				return false;
+		}
+		else
+		{
+			FILE* f = fopen(path, "wb");
+			if (!f) return false;
+			fclose(f);
+		}
+	}
+
+	return true;
+}
+
+static void _emptyScratch(Name const* names, int count)
+{
+	char path[128];
+
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(path, "%s/%s", SCRATCH_DIR, names[i].name);
+
+		if (names[i].directory)
+			rmdir(path);
+		else
+			unlink(path);
+	}
+
+	rmdir(SCRATCH_DIR);
+}
+
+static void _checkListing(Name* names, int count, bool dsiMode)
+{
+	printf("%d entries in %s mode\n", count, dsiMode ? "DSi" : "DS");
+
+	if (!_fillScratch(names, count))
+	{
+		check(false, "scratch folder filled");
+		_emptyScratch(names, count);
+		return;
+	}
+
+	hostDSiMode = dsiMode;
+
+	cpuStartTiming(0);
+	bool opened = dirListOpen(SCRATCH_DIR, SORT_NAME);
+	while (dirListStep(0));
+	u32 ticks = cpuEndTiming();
+
+	printf("listed in %u ms\n", timerTicks2msec(ticks));
+
+	check(opened, "folder opened");
+	check(dirListCount() == count, "every entry listed");
+	check(dirListSpilled() == (count > (dsiMode ? 16384 : 2048)), "spilled only when bigger than a run");
+
+	qsort(names, count, sizeof(Name), _compareNames);
+
+	//entries come back in order through the merge windows
+	int wrong = 0;
+
+	for (int i = 0; i < count && i < dirListCount(); i++)
+	{
+		char const* name = dirListName(i);
+
+		if (!name || strcmp(name, names[i].name) != 0 || dirListIsDir(i) != names[i].directory)
+		{
+			if (wrong++ < 5)
+				printf("  %d: got \"%s\", expected \"%s\"\n", i, name ? name : "(null)", names[i].name);
+		}
+	}
+
+	check(wrong == 0, "merged order matches qsort");
+
+	//paging backwards has to reload earlier windows
+	check(dirListName(0) && strcmp(dirListName(0), names[0].name) == 0, "first entry after paging");
+
+	//jump points going forward
+	int jumpWrong = 0;
+	int i = 0;
+
+	while (i >= 0)
+	{
+		int next = i + 1;
+		while (next < count && _group(&names[next]) == _group(&names[i]))
+			next++;
+
+		int expected = (next < count) ? next : -1;
+		int got = dirListJump(i, 1);
+
+		if (got != expected)
+		{
+			if (jumpWrong++ < 5)
+				printf("  jump from %d: got %d, expected %d\n", i, got, expected);
+		}
+
+		//and back from the middle of the group it lands in
+		if (got > 0 && got + 1 < count && _group(&names[got + 1]) == _group(&names[got]))
+		{
+			int back = dirListJump(got + 1, -1);
+			int start = i;
+
+			if (back != start && jumpWrong++ < 5)
+				printf("  jump back from %d: got %d, expected %d\n", got + 1, back, start);
+		}
+
+		i = got;
+	}
+
+	check(jumpWrong == 0, "jump points match letter groups");
+
+	dirListFree();
+	_emptyScratch(names, count);
+}
+
+int main(int argc, char* argv[])
+{
+	int count = (argc > 1) ? atoi(argv[1]) : 100000;
+
+	if (count <= 0)
+	{
+		printf("usage: %s [entries]\n", argv[0]);
+		return 1;
+	}
+
+	Name* names = _makeNames(count);
+	if (!names) return 1;
+
+	//DS mode holds 2048 entries per run, so this spills and merges
+	_checkListing(names, count, false);
+	free(names);
+
+	//a folder small enough to be sorted in memory
+	names = _makeNames(3000);
+	if (!names) return 1;
+
+	_checkListing(names, 3000, true);
+	free(names);
+
+	return checkResult("test_dirlist");
+}
@@ -0,0 +1,444 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_nitrofs - checks source/nitrofs.c against images written by host/nitroimg.c
+
+	usage: test_nitrofs
+
+	Each case writes a small image to build/ and mounts it the way the app does.
+*/
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds.h>
+#include <sys/iosupport.h>
+
+#include "check.h"
+#include "nitrofs.h"
+#include "nitroimg.h"
+
+#define SCRATCH_IMAGE "build/nitrofs.nds"
+
+//an image with dirCount folders counting the root, one file in each
+static bool _writeDirs(int dirCount)
+{
+	int count = dirCount - 1;
+	NitroImageFile* files = (NitroImageFile*)calloc(count, sizeof(NitroImageFile));
+	char* paths = (char*)malloc(count * 16);
+	if (!files || !paths)
+	{
+		free(files);
+		free(paths);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		sprintf(paths + i * 16, "d%04x/f", i);
+		files[i].path = paths + i * 16;
+		files[i].data = paths + i * 16;
+		files[i].size = 7;
+	}
+
+	bool ok = nitroImageWrite(SCRATCH_IMAGE, files, count);
+	free(files);
+	free(paths);
+	return ok;
+}
+
+//reads all of path on the nitro: mount into data, -1 if it cant be opened
+static int _readFile(char const* path, char* data, int size)
+{
+	struct _reent r = { 0 };
+	struct nitroFSStruct fs;
+
+	if (nitroFSOpen(&r, &fs, path, 0, 0) != 0)
+		return -1;
+
+	int len = nitroFSRead(&r, &fs, data, size);
+	nitroFSClose(&r, &fs);
+	return len;
+}
+
+//dir ids run from 0xf000, the 0x1000th folder would get 0xffff which the index uses for empty
+static void _checkDirCount()
+{
+	char path[32];
+	char data[16] = {0};
+
+	check(_writeDirs(0x0fff), "write 0xfff folders");
+	check(nitroFSInit(SCRATCH_IMAGE) == 1, "mount 0xfff folders");
+
+	sprintf(path, "d%04x/f", 0x0ffe - 1);
+	check(_readFile(path, data, sizeof(data)) == 7 && strcmp(data, path) == 0, "read in the last folder");
+
+	check(_writeDirs(0x1000), "write 0x1000 folders");
+	check(nitroFSInit(SCRATCH_IMAGE) == 0, "reject 0x1000 folders");
+}
+
+//-1 and errno for each way nitroFSExport() can fail, and a copy that matches when it doesnt
+static void _checkExport()
+{
+	static char const data[] = "exported through nitroFSExport";
+	NitroImageFile files[] = {
+		{ "sub/file.bin", data, sizeof(data) }
+	};
+
+	FILE* f = tmpfile();
+	if (!f)
+	{
+		check(false, "export scratch file");
+		return;
+	}
+
+	//a failed nitroFSInit() leaves nothing mounted
+	check(nitroFSInit("build/missing.nds") == 0, "mount a missing image");
+	errno = 0;
+	check(nitroFSExport("/sub/file.bin", f, NULL, NULL) == -1 && errno == ENODEV, "export with nothing mounted");
+
+	check(nitroImageWrite(SCRATCH_IMAGE, files, 1), "write the export image");
+	check(nitroFSInit(SCRATCH_IMAGE) == 1, "mount the export image");
+
+	errno = 0;
+	check(nitroFSExport("/sub/none.bin", f, NULL, NULL) == -1 && errno == ENOENT, "export a missing file");
+	errno = 0;
+	check(nitroFSExport("/sub", f, NULL, NULL) == -1 && errno == EISDIR, "export a folder");
+	errno = 0;
+	check(nitroFSExport("/sub/file.bin", NULL, NULL, NULL) == -1 && errno == EINVAL, "export to no file");
+	errno = 0;
+	check(nitroFSExport("none:/sub/file.bin", f, NULL, NULL) == -1 && errno == ENODEV, "export from a missing device");
+
+	char copy[sizeof(data)] = {0};
+	check(nitroFSExport("nitro:/sub/file.bin", f, NULL, NULL) == sizeof(data), "export a file");
+	rewind(f);
+	check(fread(copy, 1, sizeof(copy), f) == sizeof(data) && memcmp(copy, data, sizeof(data)) == 0, "exported data");
+	fclose(f);
+}
+
+//greedy LZ77 in the type 0x10 format nitrofs unpacks, references reach NITROLZWINDOW back
+static u8* _lzCompress(u8 const* src, u32 size, u32* outSize)
+{
+	u8* out = (u8*)malloc(4 + size + size / 8 + 1);
+	if (!out) return NULL;
+
+	u32 header = size << 8 | NITROLZTYPE;
+	memcpy(out, &header, 4);
+
+	u32 at = 4;
+	u32 pos = 0;
+	while (pos < size)
+	{
+		u32 flagAt = at++;
+		out[flagAt] = 0;
+
+		for (int bit = 0; bit < 8 && pos < size; bit++)
+		{
+			u32 bestLen = 0;
+			u32 bestDist = 0;
+			for (u32 dist = 1; dist <= NITROLZWINDOW && dist <= pos; dist++)
+			{
+				u32 len = 0;
+				while (len < 18 && pos + len < size && src[pos + len] == src[pos + len - dist])
+					len++;
+				if (len > bestLen)
+				{
+					bestLen = len;
+					bestDist = dist;
+				}
+			}
+
+			if (bestLen >= 3)
+			{
+				out[flagAt] |= 0x80 >> bit;
+				out[at++] = (bestLen - 3) << 4 | (bestDist - 1) >> 8;
+				out[at++] = (bestDist - 1) & 0xff;
+				pos += bestLen;
+			}
+			else
+			{
+				out[at++] = src[pos++];
+			}
+		}
+	}
+
+	*outSize = at;
+	return out;
+}
+
+static void _sumBytes(void* ctx, const void* data, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+		*(u32*)ctx = *(u32*)ctx * 31 + ((u8 const*)data)[i];
+}
+
+//x.bin.lz has to read back as x.bin, in pieces, after seeks both ways and through an export
+static void _checkLz()
+{
+	u32 size = 0x18000;
+	u8* data = (u8*)malloc(size);
+	u8* copy = (u8*)malloc(size);
+	if (!data || !copy)
+	{
+		check(false, "lz buffers");
+		free(data);
+		free(copy);
+		return;
+	}
+
+	//text repeats near and far, runs, and noise that stays literal
+	u32 seed = 1;
+	for (u32 i = 0; i < size; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		switch ((i / 0x800) % 4)
+		{
+			case 0: data[i] = "nitro LZ77 round trip "[i % 22]; break;
+			case 1: data[i] = (i / 0x40) & 0xff; break;
+			case 2: data[i] = seed >> 16; break;
+			default: data[i] = data[i - 0x1800 + (seed >> 28)]; break;
+		}
+	}
+
+	u32 packedSize = 0;
+	u8* packed = _lzCompress(data, size, &packedSize);
+	check(packed != NULL && packedSize < size, "lz compress");
+	if (!packed)
+	{
+		free(data);
+		free(copy);
+		return;
+	}
+
+	NitroImageFile files[] = {
+		{ "lz/x.bin.lz", packed, packedSize },
+		{ "lz/plain.lz", "not LZ77", 8 }
+	};
+	check(nitroImageWrite(SCRATCH_IMAGE, files, 2), "write the lz image");
+	check(nitroFSInit(SCRATCH_IMAGE) == 1, "mount the lz image");
+
+	struct _reent r = { 0 };
+	struct nitroFSStruct fs;
+	struct stat st;
+
+	//a .lz without the header stays as it is
+	check(nitroFSstat(&r, "/lz/plain.lz", &st) == 0 && st.st_size == 8, "plain .lz kept");
+
+	if (nitroFSOpen(&r, &fs, "/lz/x.bin", 0, 0) != 0)
+	{
+		check(false, "open x.bin");
+	}
+	else
+	{
+		check(nitroFSFstat(&r, &fs, &st) == 0 && st.st_size == size, "x.bin size");
+
+		//odd sized pieces, so they cross flag groups and references
+		memset(copy, 0, size);
+		u32 pos = 0;
+		while (pos < size)
+		{
+			ssize_t got = nitroFSRead(&r, &fs, (char*)copy + pos, 777);
+			if (got <= 0) break;
+			pos += got;
+		}
+		check(pos == size && memcmp(copy, data, size) == 0, "read x.bin in pieces");
+
+		//back to the middle, then skip forward
+		u32 offsets[] = { 0x9001, 0x100, 0x17ff0, 0x2345 };
+		for (int i = 0; i < 4; i++)
+		{
+			u32 len = (size - offsets[i] < 0x1000) ? size - offsets[i] : 0x1000;
+			nitroFSSeek(&r, &fs, offsets[i], SEEK_SET);
+			check(nitroFSRead(&r, &fs, (char*)copy, len) == len && memcmp(copy, data + offsets[i], len) == 0, "read x.bin after a seek");
+		}
+
+		nitroFSClose(&r, &fs);
+	}
+
+	u32 sum = 0;
+	u32 expected = 0;
+	_sumBytes(&expected, data, size);
+
+	FILE* f = tmpfile();
+	check(f && nitroFSExport("/lz/x.bin", f, _sumBytes, &sum) == size && sum == expected, "export x.bin");
+	if (f)
+	{
+		rewind(f);
+		check(fread(copy, 1, size, f) == size && memcmp(copy, data, size) == 0, "exported x.bin");
+		fclose(f);
+	}
+
+	free(packed);
+	free(data);
+	free(copy);
+}
+
+typedef struct {
+	char const* device;	//with the colon
+	char who;
+	int failures;
+} Reader;
+
+static atomic_bool readersDone = false;
+
+//reads its own mount over and over while the main thread mounts and unmounts next to it
+static void* _readMount(void* arg)
+{
+	Reader* reader = (Reader*)arg;
+	const devoptab_t* tab = GetDeviceOpTab(reader->device);
+
+	if (!tab || !tab->deviceData)
+	{
+		reader->failures++;
+		return NULL;
+	}
+
+	struct _reent r = { 0 };
+	r.deviceData = tab->deviceData;
+
+	while (!atomic_load(&readersDone))
+	{
+		struct nitroFSStruct fs;
+		char data[0x1000];
+
+		if (tab->open_r(&r, &fs, "/who.txt", 0, 0) != 0)
+		{
+			reader->failures++;
+			continue;
+		}
+
+		if (tab->read_r(&r, &fs, data, sizeof(data)) != 1 || data[0] != reader->who)
+			reader->failures++;
+
+		tab->close_r(&r, &fs);
+
+		if (tab->open_r(&r, &fs, "/big.bin", 0, 0) != 0)
+		{
+			reader->failures++;
+			continue;
+		}
+
+		tab->seek_r(&r, &fs, 0x3000, SEEK_SET);
+		if (tab->read_r(&r, &fs, data, sizeof(data)) != sizeof(data) || data[0] != reader->who || data[sizeof(data) - 1] != reader->who)
+			reader->failures++;
+
+		tab->close_r(&r, &fs);
+	}
+
+	return NULL;
+}
+
+static bool _writeWho(char const* path, char const* who)
+{
+	static char big[0x8000];
+	memset(big, who[0], sizeof(big));
+
+	NitroImageFile files[] = {
+		{ "who.txt", who, 1 },
+		{ "big.bin", big, sizeof(big) }
+	};
+	return nitroImageWrite(path, files, 2);
+}
+
+//two mounts read in threads while a third comes and goes, with sd: as the default device
+static void _checkMounts()
+{
+	static const devoptab_t sd = { "sd" };
+	int sdDevice = AddDevice(&sd);
+	setDefaultDevice(sdDevice);
+
+	check(_writeWho("build/nitrofs_a.nds", "a"), "write image a");
+	check(_writeWho("build/nitrofs_b.nds", "b"), "write image b");
+	check(_writeWho("build/nitrofs_c.nds", "c"), "write image c");
+
+	check(nitroFSMount("a", "build/nitrofs_a.nds") == 1, "mount a");
+	check(nitroFSMount("b", "build/nitrofs_b.nds") == 1, "mount b");
+	check(nitroFSMount("a", "build/nitrofs_c.nds") == 0, "mount a twice");
+	check(nitroFSMount("sd", "build/nitrofs_c.nds") == 0, "mount over sd");
+	check(nitroFSMount("c:", "build/nitrofs_c.nds") == 0, "mount with a colon");
+	check(GetDeviceOpTab("sd:") == &sd, "sd kept");
+
+	Reader readers[2] = {
+		{ "a:", 'a', 0 },
+		{ "b:", 'b', 0 }
+	};
+	pthread_t threads[2];
+
+	atomic_store(&readersDone, false);
+	for (int i = 0; i < 2; i++)
+		pthread_create(&threads[i], NULL, _readMount, &readers[i]);
+
+	for (int i = 0; i < 200; i++)
+	{
+		char data[4] = {0};
+
+		check(nitroFSMount("c", "build/nitrofs_c.nds") == 1, "mount c");
+		check(nitroFSExport("c:/who.txt", NULL, NULL, NULL) == -1, "export c to no file");
+
+		FILE* f = tmpfile();
+		if (f)
+		{
+			check(nitroFSExport("c:/who.txt", f, NULL, NULL) == 1, "export from c");
+			rewind(f);
+			check(fread(data, 1, sizeof(data), f) == 1 && data[0] == 'c', "read from c");
+			fclose(f);
+		}
+
+		check(nitroFSUnmount("c") == 1, "unmount c");
+		check(GetDeviceOpTab("c:") == NULL, "c gone");
+	}
+
+	atomic_store(&readersDone, true);
+	for (int i = 0; i < 2; i++)
+	{
+		pthread_join(threads[i], NULL);
+		check(readers[i].failures == 0, "read while mounting");
+	}
+
+	//names that arent nitroFSMount() mounts, which without the colon would find sd:
+	check(nitroFSUnmount("sd") == 0, "unmount sd");
+	check(nitroFSUnmount("nitro") == 0, "unmount nitro");
+	check(nitroFSUnmount("c") == 0, "unmount c twice");
+	check(GetDeviceOpTab("sd:") == &sd, "sd still there");
+
+	check(nitroFSUnmount("a") == 1 && nitroFSUnmount("b") == 1, "unmount a and b");
+	check(GetDeviceOpTab("sd:") == &sd, "sd after unmounting");
+
+	RemoveDevice("sd:");
+	setDefaultDevice(0);
+	remove("build/nitrofs_a.nds");
+	remove("build/nitrofs_b.nds");
+	remove("build/nitrofs_c.nds");
+}
+
+int main(int argc, char* argv[])
+{
+	_checkDirCount();
+	_checkExport();
+	_checkLz();
+	_checkMounts();
+
+	remove(SCRATCH_IMAGE);
+	return checkResult("test_nitrofs");
+}
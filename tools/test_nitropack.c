@@ -0,0 +1,223 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_nitropack - packs images written by host/nitroimg.c with build/nitropack and reads
+	them back through source/nitrofs.c
+
+	usage: test_nitropack
+
+	Run from tools/, after make has built build/nitropack. Every file has to read back the
+	same after packing, the listed ones first, and an image nitropack can't pack has to be
+	left byte for byte as it was with a note on stderr.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds.h>
+
+#include "check.h"
+#include "nitrofs.h"
+#include "nitroimg.h"
+
+#define SCRATCH_IMAGE "build/nitropack.nds"
+#define SCRATCH_OUT "build/nitropack.out"
+#define SCRATCH_ERR "build/nitropack.err"
+#define SECTOR 0x200
+
+//the same order the app's Makefile gives it
+#define PACK SCRATCH_IMAGE " sdcard.nds flashcard.nds"
+
+typedef struct {
+	char const* path;
+	u32 size;
+	u8* data;
+} TestFile;
+
+static TestFile testFiles[] = {
+	{ "title.txt", 11 },
+	{ "empty.txt", 0 },
+	{ "sub/b.bin", SECTOR },
+	{ "sub/deep/a.bin", SECTOR + 1 },
+	{ "flashcard.nds", 1000 },
+	{ "sdcard.nds", 3000 },
+};
+
+#define TEST_FILE_COUNT ((int)(sizeof(testFiles) / sizeof(testFiles[0])))
+
+static bool _writeTestImage()
+{
+	NitroImageFile files[TEST_FILE_COUNT];
+	u32 seed = 7;
+
+	for (int i = 0; i < TEST_FILE_COUNT; i++)
+	{
+		if (!testFiles[i].data)
+			testFiles[i].data = (u8*)malloc(testFiles[i].size + 1);
+
+		for (u32 b = 0; b < testFiles[i].size; b++)
+		{
+			seed = seed * 1103515245 + 12345;
+			testFiles[i].data[b] = seed >> 16;
+		}
+
+		files[i].path = testFiles[i].path;
+		files[i].data = testFiles[i].data;
+		files[i].size = testFiles[i].size;
+	}
+
+	return nitroImageWrite(SCRATCH_IMAGE, files, TEST_FILE_COUNT);
+}
+
+//the whole of path on the host into a new buffer, NULL if it can't be read
+static u8* _loadFile(char const* path, u32* size)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f) return NULL;
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	u8* data = (u8*)malloc(*size + 1);
+	if (data && fread(data, 1, *size, f) != *size)
+	{
+		free(data);
+		data = NULL;
+	}
+
+	fclose(f);
+	return data;
+}
+
+static u32 _get32(u8 const* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+//mounts the scratch image and compares every file in it with what was written
+static void _checkFiles(char const* what)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "mount %s", what);
+	check(nitroFSInit(SCRATCH_IMAGE) == 1, name);
+
+	for (int i = 0; i < TEST_FILE_COUNT; i++)
+	{
+		struct _reent r = { 0 };
+		struct nitroFSStruct fs;
+		u8* data = (u8*)malloc(testFiles[i].size + 1);
+		int len = -1;
+
+		if (nitroFSOpen(&r, &fs, testFiles[i].path, 0, 0) == 0)
+		{
+			len = nitroFSRead(&r, &fs, (char*)data, testFiles[i].size + 1);
+			nitroFSClose(&r, &fs);
+		}
+
+		snprintf(name, sizeof(name), "%s in %s", testFiles[i].path, what);
+		check(len == (int)testFiles[i].size && memcmp(data, testFiles[i].data, len) == 0, name);
+		free(data);
+	}
+}
+
+static void _checkPack()
+{
+	check(_writeTestImage(), "write the image");
+	_checkFiles("the image");
+
+	check(system("build/nitropack " PACK " > " SCRATCH_OUT " 2> " SCRATCH_ERR) == 0, "pack the image");
+
+	u32 errSize = 1;
+	u8* err = _loadFile(SCRATCH_ERR, &errSize);
+	check(err && errSize == 0, "nothing on stderr");
+	free(err);
+
+	_checkFiles("the packed image");
+
+	//the listed files go first, each on its own sector, from where the first file was
+	u32 size = 0;
+	u8* image = _loadFile(SCRATCH_IMAGE, &size);
+	if (!image || size < SECTOR)
+	{
+		check(false, "read the packed image");
+		free(image);
+		return;
+	}
+
+	u32 base = (_get32(image + 0x48) + _get32(image + 0x4C) + SECTOR - 1) & ~(SECTOR - 1);
+	u32 second = (base + testFiles[5].size + SECTOR - 1) & ~(SECTOR - 1);
+
+	check(base + testFiles[5].size <= size && memcmp(image + base, testFiles[5].data, testFiles[5].size) == 0, "sdcard.nds first");
+	check(second + testFiles[4].size <= size && memcmp(image + second, testFiles[4].data, testFiles[4].size) == 0, "flashcard.nds second");
+	check(_get32(image + 0x80) == size, "used ROM size");
+	free(image);
+}
+
+//a banner after the first file is more than file data, nitropack has to leave that alone
+static void _checkSkip()
+{
+	check(_writeTestImage(), "write the image to skip");
+
+	u32 size = 0;
+	u8* image = _loadFile(SCRATCH_IMAGE, &size);
+	FILE* f = fopen(SCRATCH_IMAGE, "r+b");
+	if (!image || size < SECTOR || !f)
+	{
+		check(false, "open the image to skip");
+		free(image);
+		if (f) fclose(f);
+		return;
+	}
+
+	u32 base = (_get32(image + 0x48) + _get32(image + 0x4C) + SECTOR - 1) & ~(SECTOR - 1);
+	memcpy(image + 0x68, &base, 4);
+	check(fseek(f, 0x68, SEEK_SET) == 0 && fwrite(&base, 1, 4, f) == 4, "banner after the first file");
+	fclose(f);
+
+	check(system("build/nitropack " PACK " > " SCRATCH_OUT " 2> " SCRATCH_ERR) == 0, "skip the image");
+
+	u32 errSize = 0;
+	char* err = (char*)_loadFile(SCRATCH_ERR, &errSize);
+	if (err) err[errSize] = '\0';
+	check(err && strstr(err, "left as is") != NULL, "skip noted on stderr");
+	free(err);
+
+	u32 afterSize = 0;
+	u8* after = _loadFile(SCRATCH_IMAGE, &afterSize);
+	check(after && afterSize == size && memcmp(after, image, size) == 0, "skipped image unchanged");
+	free(after);
+	free(image);
+
+	_checkFiles("the skipped image");
+}
+
+int main(int argc, char* argv[])
+{
+	_checkPack();
+	_checkSkip();
+
+	for (int i = 0; i < TEST_FILE_COUNT; i++)
+		free(testFiles[i].data);
+
+	return checkResult("test_nitropack");
+}
@@ -0,0 +1,98 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_sha1 - checks source/sha1.c against the FIPS 180 example digests
+
+	usage: test_sha1
+
+	Each message is hashed in one sha1Calc() call and again fed in uneven pieces, so partial
+	blocks get topped up across updates.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds.h>
+
+#include "check.h"
+#include "sha1.h"
+
+typedef struct {
+	char const* name;
+	char const* message;	//NULL for the million 'a'
+	char const* digest;
+} Vector;
+
+static const Vector vectors[] = {
+	{ "abc", "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+	{ "empty", "", "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+	{ "448 bits", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+	{ "million a", NULL, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" }
+};
+
+static void _hex(char* out, u8 const* digest)
+{
+	for (int i = 0; i < SHA1_DIGEST_LENGTH; i++)
+		sprintf(out + i * 2, "%02x", digest[i]);
+}
+
+static void _checkVector(Vector const* v)
+{
+	u32 len = v->message ? strlen(v->message) : 1000000;
+	u8* message = (u8*)malloc(len + 1);
+	if (!message) return;
+
+	if (v->message)
+		memcpy(message, v->message, len);
+	else
+		memset(message, 'a', len);
+
+	u8 digest[SHA1_DIGEST_LENGTH];
+	char hex[SHA1_DIGEST_LENGTH * 2 + 1];
+	char what[64];
+
+	sha1Calc(digest, message, len);
+	_hex(hex, digest);
+	sprintf(what, "%s in one piece", v->name);
+	check(strcmp(hex, v->digest) == 0, what);
+
+	//pieces of 1 to 97 bytes, crossing the 64 byte blocks everywhere
+	Sha1Context ctx;
+	sha1Init(&ctx);
+
+	for (u32 pos = 0, piece = 1; pos < len; pos += piece, piece = piece % 97 + 1)
+		sha1Update(&ctx, message + pos, (len - pos < piece) ? len - pos : piece);
+
+	sha1Final(digest, &ctx);
+	_hex(hex, digest);
+	sprintf(what, "%s in pieces", v->name);
+	check(strcmp(hex, v->digest) == 0, what);
+
+	free(message);
+}
+
+int main(int argc, char* argv[])
+{
+	for (int i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+		_checkVector(&vectors[i]);
+
+	return checkResult("test_sha1");
+}
@@ -0,0 +1,226 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	test_tmd - checks the TMD builder in source/maketmd.c
+
+	usage: test_tmd
+
+	Writes a synthetic app to build/ and makes its TMD with maketmd(), which reads the app in
+	one pass. The same app fed to a TmdBuilder in pieces of several sizes has to give the
+	same TMD, and the header fields, size and SHA1 sum have to be where the DSi looks.
+	maketmdCached() then has to reuse a hash for the same key and size only, and give up
+	without a TMD when it can't read the header.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nds.h>
+
+#include "check.h"
+#include "main.h"
+#include "maketmd.h"
+#include "sha1.h"
+
+#define APP_PATH "build/tmd.app"
+#define TMD_PATH "build/tmd.tmd"
+#define APP_SIZE (sizeof(tDSiHeader) + 0x31234)
+
+static u8* _makeApp()
+{
+	u8* app = (u8*)malloc(APP_SIZE);
+	if (!app) return NULL;
+
+	u32 seed = 7;
+	for (u32 i = 0; i < APP_SIZE; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		app[i] = seed >> 16;
+	}
+
+	tDSiHeader* header = (tDSiHeader*)app;
+	memcpy(header->ndshdr.gameCode, "KNFA", 4);
+	memcpy(header->ndshdr.makercode, "01", 2);
+	header->tid_low = 0x4B4E4641;
+	header->tid_high = 0x00030004;
+
+	return app;
+}
+
+static bool _writeFile(char const* path, void const* data, u32 size)
+{
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+
+	bool result = fwrite(data, 1, size, f) == size;
+	fclose(f);
+	return result;
+}
+
+static bool _readFile(char const* path, void* data, u32 size)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f) return false;
+
+	bool result = fread(data, 1, size, f) == size && fgetc(f) == EOF;
+	fclose(f);
+	return result;
+}
+
+//the app fed in pieces of size bytes, the last one shorter
+static void _buildInPieces(u8 const* app, u32 size, u8* tmd)
+{
+	TmdBuilder builder;
+	tmdInit(&builder, (tDSiHeader const*)app);
+
+	for (u32 pos = 0; pos < APP_SIZE; pos += size)
+		tmdUpdate(&builder, app + pos, (APP_SIZE - pos < size) ? APP_SIZE - pos : size);
+
+	tmdFinal(&builder, tmd);
+}
+
+static TmdKey _key(u32 tidLow)
+{
+	TmdKey key;
+	memset(&key, 0, sizeof(key));
+	key.tidLow = tidLow;
+	key.tidHigh = 0x00030004;
+	key.templateCrc = 0x1234;
+	key.headerCrc = 0x5678;
+	key.pathHash = tmdPathHash("sd:/roms/game.nds", 17);
+	return key;
+}
+
+//a hit is told apart from a miss by changing the app behind the cache's back
+static void _checkCache(u8* app, u8 const* tmd)
+{
+	u8 got[TMD_SIZE];
+	u8 fresh[TMD_SIZE];
+	TmdKey key = _key(1);
+
+	remove(TMD_CACHE_PATH);
+
+	check(maketmdCached(APP_PATH, TMD_PATH, &key) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "cache miss");
+	check(memcmp(got, tmd, TMD_SIZE) == 0, "cache miss TMD");
+
+	//same key and size, the stale hash comes back without reading the app
+	app[APP_SIZE - 1] ^= 1;
+	_writeFile(APP_PATH, app, APP_SIZE);
+	_buildInPieces(app, APP_SIZE, fresh);
+
+	check(maketmdCached(APP_PATH, TMD_PATH, &key) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "cache hit");
+	check(memcmp(got, tmd, TMD_SIZE) == 0, "cache hit TMD");
+
+	//another key misses
+	TmdKey other = _key(2);
+	check(maketmdCached(APP_PATH, TMD_PATH, &other) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "other key");
+	check(memcmp(got, fresh, TMD_SIZE) == 0, "other key TMD");
+
+	//so does another size under the first key
+	_writeFile(APP_PATH, app, APP_SIZE - 0x200);
+	check(maketmdCached(APP_PATH, TMD_PATH, &key) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "other size");
+	check(memcmp(got + 0x1F4, tmd + 0x1F4, SHA1_DIGEST_LENGTH) != 0, "other size TMD");
+
+	//no key never touches the cache
+	_writeFile(APP_PATH, app, APP_SIZE);
+	check(maketmd(APP_PATH, TMD_PATH) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "no key");
+	check(memcmp(got, fresh, TMD_SIZE) == 0, "no key TMD");
+
+	//64 newer keys push the first one out
+	for (u32 i = 0; i < 64; i++)
+	{
+		TmdKey newer = _key(100 + i);
+		maketmdCached(APP_PATH, TMD_PATH, &newer);
+	}
+
+	//a hit would give the old hash
+	app[APP_SIZE - 1] ^= 1;
+	_writeFile(APP_PATH, app, APP_SIZE);
+
+	check(maketmdCached(APP_PATH, TMD_PATH, &other) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "evicted key");
+	check(memcmp(got, tmd, TMD_SIZE) == 0, "evicted key TMD");
+
+	//the newest is still there
+	TmdKey newest = _key(100 + 63);
+	check(maketmdCached(APP_PATH, TMD_PATH, &newest) == 0 && _readFile(TMD_PATH, got, TMD_SIZE), "newest key");
+	check(memcmp(got, fresh, TMD_SIZE) == 0, "newest key TMD");
+
+	//a hit reads the whole header, an app too short for one leaves no TMD behind
+	TmdKey shortKey = _key(200);
+	_writeFile(APP_PATH, app, 0x200);
+	check(maketmdCached(APP_PATH, TMD_PATH, &shortKey) == 0, "short app");
+	check(maketmdCached(APP_PATH, TMD_PATH, &shortKey) == 1 && !_readFile(TMD_PATH, got, TMD_SIZE), "short app hit");
+
+	remove(TMD_CACHE_PATH);
+}
+
+int main(int argc, char* argv[])
+{
+	u8* app = _makeApp();
+	if (!app) return 1;
+
+	u8 tmd[TMD_SIZE];
+	u8 pieces[TMD_SIZE];
+
+	check(_writeFile(APP_PATH, app, APP_SIZE), "write the app");
+	check(maketmd(APP_PATH, TMD_PATH) == 0, "maketmd");
+	check(_readFile(TMD_PATH, tmd, TMD_SIZE), "read the TMD");
+
+	//where the DSi looks
+	u8 sha1[SHA1_DIGEST_LENGTH];
+	sha1Calc(sha1, app, APP_SIZE);
+
+	u32 size = __builtin_bswap32(APP_SIZE);
+	u32 tidHigh = __builtin_bswap32(0x00030004);
+
+	check(memcmp(tmd + 0x18C, &tidHigh, 4) == 0, "title id high");
+	check(memcmp(tmd + 0x190, "KNFA", 4) == 0, "title id low");
+	check(memcmp(tmd + 0x198, "01", 2) == 0, "group id");
+	check(tmd[0x1DF] == 1 && tmd[0x1EB] == 1, "content count and type");
+	check(memcmp(tmd + 0x1F0, &size, 4) == 0, "app size");
+	check(memcmp(tmd + 0x1F4, sha1, SHA1_DIGEST_LENGTH) == 0, "app sha1");
+
+	//as an install copying the app would feed it
+	u32 sizes[] = { 1, 63, 64, 65, 0x200, 0x1000, 0x1001, APP_SIZE };
+	for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		char what[64];
+		sprintf(what, "built in pieces of %u", sizes[i]);
+
+		_buildInPieces(app, sizes[i], pieces);
+		check(memcmp(pieces, tmd, TMD_SIZE) == 0, what);
+	}
+
+	//the TMD follows the app
+	app[APP_SIZE / 2] ^= 1;
+	_buildInPieces(app, 0x1000, pieces);
+	check(memcmp(pieces + 0x1F4, tmd + 0x1F4, SHA1_DIGEST_LENGTH) != 0, "changed app");
+	app[APP_SIZE / 2] ^= 1;
+
+	check(_writeFile(APP_PATH, app, APP_SIZE), "write the app again");
+	_checkCache(app, tmd);
+
+	free(app);
+	remove(APP_PATH);
+	remove(TMD_PATH);
+
+	return checkResult("test_tmd");
+}
@@ -0,0 +1,202 @@
+/*
+    NDSForwarder for DSi
+    Copyright (C) 2018-2020 JeffRuLz
+    Copyright (C) 2022-present lifehackerhansol
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	tmdcheck - the Test menu TMD check of source/maketmd.c, run on a mounted SD card
+
+	usage: tmdcheck [-n] <sd root>
+
+	Verifies the title.tmd of every title in <sd root>/title/0003000{4,5}/ and 00030015/
+	against its app, rewriting the unsigned ones that don't match. -n only reports. Titles
+	are handed out to one worker thread per core.
+*/
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nds.h>
+
+#include "maketmd.h"
+
+typedef struct {
+	char path[512];	//content folder
+	int result;
+} Title;
+
+typedef struct {
+	Title* titles;
+	int count;
+	int next;
+	bool repair;
+	pthread_mutex_t lock;
+} Work;
+
+static const char* dirs[] = {
+	"00030004",
+	"00030005",
+	"00030015"
+};
+
+static const char* resultNames[] = {
+	"OK",
+	"Fixed",
+	"Bad",
+	"No app"
+};
+
+static bool _addTitles(char const* root, Title** titles, int* count, int* cap)
+{
+	for (int i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++)
+	{
+		char path[512];
+		snprintf(path, sizeof(path), "%s/title/%s", root, dirs[i]);
+
+		DIR* dir = opendir(path);
+		if (!dir) continue;
+
+		struct dirent* ent;
+
+		while ( (ent = readdir(dir)) )
+		{
+			if (ent->d_type != DT_DIR || strlen(ent->d_name) != 8)
+				continue;
+
+			if (*count >= *cap)
+			{
+				int n = *cap ? *cap * 2 : 64;
+				Title* t = (Title*)realloc(*titles, n * sizeof(Title));
+
+				if (!t)
+				{
+					closedir(dir);
+					return false;
+				}
+
+				*titles = t;
+				*cap = n;
+			}
+
+			Title* title = &(*titles)[(*count)++];
+			snprintf(title->path, sizeof(title->path), "%s/%s/content", path, ent->d_name);
+			title->result = TMD_VERIFY_ERROR;
+		}
+
+		closedir(dir);
+	}
+
+	return true;
+}
+
+static void* _worker(void* arg)
+{
+	Work* work = (Work*)arg;
+
+	while (1)
+	{
+		pthread_mutex_lock(&work->lock);
+		int i = work->next++;
+		pthread_mutex_unlock(&work->lock);
+
+		if (i >= work->count)
+			break;
+
+		work->titles[i].result = tmdVerify(work->titles[i].path, work->repair);
+	}
+
+	return NULL;
+}
+
+static int _compareTitles(const void* a, const void* b)
+{
+	return strcmp(((Title const*)a)->path, ((Title const*)b)->path);
+}
+
+int main(int argc, char* argv[])
+{
+	Work work = { NULL, 0, 0, true, PTHREAD_MUTEX_INITIALIZER };
+	char const* root = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0)
+			work.repair = false;
+		else
+			root = argv[i];
+	}
+
+	if (!root)
+	{
+		printf("usage: %s [-n] <sd root>\n", argv[0]);
+		return 1;
+	}
+
+	int cap = 0;
+	if (!_addTitles(root, &work.titles, &work.count, &cap))
+	{
+		printf("out of memory\n");
+		return 1;
+	}
+
+	qsort(work.titles, work.count, sizeof(Title), _compareTitles);
+
+	int threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threadCount < 1) threadCount = 1;
+	if (threadCount > work.count) threadCount = work.count;
+
+	pthread_t* threads = (pthread_t*)malloc(threadCount * sizeof(pthread_t));
+	if (!threads && threadCount > 0)
+	{
+		printf("out of memory\n");
+		return 1;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (int i = 0; i < threadCount; i++)
+		pthread_create(&threads[i], NULL, _worker, &work);
+
+	for (int i = 0; i < threadCount; i++)
+		pthread_join(threads[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	int counts[4] = { 0 };
+
+	for (int i = 0; i < work.count; i++)
+	{
+		printf("%s %s\n", work.titles[i].path, resultNames[work.titles[i].result]);
+		counts[work.titles[i].result]++;
+	}
+
+	double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+	printf("\n%d checked, %d fixed, %d bad, %d without an app in %.0f ms on %d thread%s\n",
+		   work.count, counts[TMD_VERIFY_REPAIRED], counts[TMD_VERIFY_MISMATCH], counts[TMD_VERIFY_ERROR],
+		   ms, threadCount, threadCount == 1 ? "" : "s");
+
+	free(threads);
+	free(work.titles);
+
+	return (counts[TMD_VERIFY_MISMATCH] || counts[TMD_VERIFY_ERROR]) ? 2 : 0;
+}